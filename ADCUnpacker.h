@@ -12,6 +12,10 @@
  *Updated to better handle errors and work with a more general version of evt2root
  *Gordon M. April 2019
  *
+ *Now only the module descriptor for the generic ModuleUnpacker, which reads whole 32-bit
+ *words. Covers the CAEN V785 ADC and V775 TDC, which share this format.
+ *Oct 2026
+ *
  *NOTE: This version is specifically designed to unpack data that come in reverse!!
  */
 
@@ -19,33 +23,36 @@
 #ifndef adcunpacker_h
 #define adcunpacker_h
 
-#include <vector>
-#include <utility>
-#include <cstdint>
-#include <stdexcept>
-
-struct ParsedADCEvent {
-  int s_geo;
-  int s_crate;
-  int s_count;
-  int s_eventNumber;   
-  std::vector<std::pair<int, std::uint16_t>> s_data;
-};
+#include "ModuleUnpacker.h"
+
+//This is where most chagnes need to be made for each module; most else is just name changes
+//useful masks and shifts for ADC:
+struct ADCDescriptor {
+  static const std::uint32_t TYPE_MASK = 0x07000000;
+  static const std::uint32_t TYPE_HDR = 0x02000000;
+  static const std::uint32_t TYPE_DATA = 0x00000000;
+  static const std::uint32_t TYPE_TRAIL = 0x04000000;
+
+  static const unsigned ID_SHIFT = 27; //geo
+  static const std::uint32_t ID_MASK = 0xf8000000;
 
-class ADCUnpacker {
-  public:
-    std::pair< uint16_t*, ParsedADCEvent> parse( uint16_t* begin,  uint16_t* end,
-                                                 std::vector<int> geos);
-    bool isHeader(std::uint16_t word);
-
-  private:
-    bool isData(std::uint16_t word);
-    bool isEOE(std::uint16_t word); 
-   
-    void unpackHeader(std::uint16_t* word, ParsedADCEvent& event);
-    void unpackDatum(std::uint16_t* word, ParsedADCEvent& event); 
-    uint16_t* unpackData( uint16_t* begin,  uint16_t* end, ParsedADCEvent& event); 
+  //header-specific:
+  static const unsigned COUNT_SHIFT = 8;
+  static const std::uint32_t COUNT_MASK = 0x00003f00;
+  static const int COUNT_EXTRA = 0; //count is data words only
+  static const unsigned CRATE_SHIFT = 16;
+  static const std::uint32_t CRATE_MASK = 0x00ff0000;
+  static const unsigned RES_SHIFT = 0;
+  static const std::uint32_t RES_MASK = 0;
+
+  //data-specific:
+  static const unsigned CHAN_SHIFT = 16;
+  static const std::uint32_t CHAN_MASK = 0x001f0000;
+  static const std::uint32_t DATA_MASK = 0x00003fff;
+
+  static const bool BAD_DATUM_DROPS_BLOCK = false; //a bad datum reads as 0 at channel 0, as before
 };
 
+typedef ModuleUnpacker<ADCDescriptor> ADCUnpacker;
+
 #endif
-        
@@ -0,0 +1,61 @@
+/*Calibration.cpp
+ *Scalar and AVX2 kernels for the batched calibration stage. The AVX2 kernel is
+ *compiled with a target attribute and picked at run time, as in WordScan.cpp. It only
+ *uses the operations of the scalar code (no FMA), in the same order, so the results match
+ *bit for bit.
+ *
+ *Oct 2026
+ */
+
+#include "Calibration.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CALIBRATION_X86 1
+#endif
+
+using namespace std;
+
+void rebinModuleScalar(int32_t* module, const float* r) {
+  for (int i=0; i<32; i++) {
+    if (module[i] != 0) {
+      float value = module[i]+r[i];
+      module[i] = (int32_t) value;
+    }
+  }
+}
+
+#ifdef CALIBRATION_X86
+__attribute__((target("avx2")))
+static void rebinModuleAVX2(int32_t* module, const float* r) {
+  const __m256i zero = _mm256_setzero_si256();
+  for (int i=0; i<32; i+=8) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)(module+i));
+    __m256 value = _mm256_add_ps(_mm256_cvtepi32_ps(v), _mm256_loadu_ps(r+i));
+    __m256i rebinned = _mm256_cvttps_epi32(value);
+    __m256i keep = _mm256_cmpeq_epi32(v, zero);
+    _mm256_storeu_si256((__m256i*)(module+i), _mm256_blendv_epi8(rebinned, v, keep));
+  }
+}
+#endif
+
+struct CalibrationKernels {
+  const char* name;
+  void (*rebin)(int32_t*, const float*);
+};
+
+static CalibrationKernels pickKernels() {
+#ifdef CALIBRATION_X86
+  if (__builtin_cpu_supports("avx2")) return {"avx2", rebinModuleAVX2};
+#endif
+  return {"scalar", rebinModuleScalar};
+}
+
+static const CalibrationKernels kernels = pickKernels();
+
+void rebinModule(int32_t* module, const float* r) {
+  kernels.rebin(module, r);
+}
+
+const char* calibrationImpl() {
+  return kernels.name;
+}
@@ -0,0 +1,25 @@
+/*Calibration.h
+ *Batched calibration stage: the vector kernel that dithers the raw channels of a module
+ *(evt2root::Rebin()) for a block of events at a time, and the batch size. The derived
+ *parameters of a batch are computed by the setup's compiled program (ParamProgram.h).
+ *Results are bit-identical to the per-event code.
+ *
+ *Plain types only, so the benchmark can be built without ROOT.
+ *
+ *Oct 2026
+ */
+
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+#include <cstdint>
+#include <cstddef>
+
+const std::size_t CALIB_BATCH = 256; //events per batch
+
+//dither the 32 channels of one module: nonzero channels become (int)(channel + r)
+void rebinModule(std::int32_t* module, const float* r);
+void rebinModuleScalar(std::int32_t* module, const float* r);
+const char* calibrationImpl(); //name of the kernel rebinModule() uses
+
+#endif
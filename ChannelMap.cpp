@@ -0,0 +1,302 @@
+/*ChannelMap.cpp
+ *Reads the detector setup; see ChannelMap.h
+ *
+ *Oct 2026
+ */
+
+#include "ChannelMap.h"
+#include "ADCUnpacker.h"
+#include "mTDCUnpacker.h"
+#include <fstream>
+#include <sstream>
+#include <cctype>
+#include <cstdlib>
+
+using namespace std;
+
+//the SPS focal plane, as evt2root's constructor and setParameters() used to hard-code it
+static const char* SPS_SETUP =
+  "# SPS focal plane\n"
+  "module adc1 adc 3\n"
+  "module adc2 adc 4\n"
+  "module adc3 adc 5\n"
+  "module tdc1 adc 8\n"
+  "module mtdc1 mtdc 9\n"
+  "\n"
+  "const nanos_per_chan = 0.0625 # ps -> ns for the mTDC\n"
+  "\n"
+  "# delay line ends, in ns\n"
+  "temp mtdc102 = dither(mtdc1[2])*nanos_per_chan\n"
+  "temp mtdc101 = dither(mtdc1[1])*nanos_per_chan\n"
+  "temp mtdc103 = dither(mtdc1[3])*nanos_per_chan\n"
+  "temp mtdc104 = dither(mtdc1[4])*nanos_per_chan\n"
+  "\n"
+  "param fp_plane1_tdiff = (mtdc102-mtdc101)/2\n"
+  "param fp_plane1_tsum = mtdc102+mtdc101\n"
+  "param fp_plane1_tave = (mtdc102+mtdc101)/2\n"
+  "param fp_plane2_tdiff = (mtdc104-mtdc103)/2\n"
+  "param fp_plane2_tsum = mtdc104+mtdc103\n"
+  "param fp_plane2_tave = (mtdc104+mtdc103)/2\n"
+  "\n"
+  "alias anode1 = adc3[4]\n"
+  "alias anode2 = adc3[5]\n"
+  "alias scint1 = adc3[6]\n"
+  "alias scint2 = adc3[9]\n"
+  "alias cathode = adc3[8]\n"
+  "\n"
+  "param plastic_sum = dither(scint1)+dither(scint2)\n"
+  "param anode1_time = dither(mtdc1[5])\n"
+  "param anode2_time = dither(mtdc1[6])\n"
+  "param plastic_time = dither(mtdc1[7])\n";
+
+static bool isName(const string& name) {
+  if (name.empty() || !(isalpha((unsigned char) name[0]) || name[0] == '_')) return false;
+  for (char c : name) {
+    if (!isalnum((unsigned char) c) && c != '_') return false;
+  }
+  return true;
+}
+
+ChannelMap::ChannelMap() {
+  parse(SPS_SETUP, "built-in");
+}
+
+const char* ChannelMap::defaultSetup() {
+  return SPS_SETUP;
+}
+
+/*load()
+ *Reads a setup file. On failure the error names the file and line.
+ */
+bool ChannelMap::load(const string& fileName) {
+  ifstream file(fileName.c_str());
+  if (!file) {
+    error = "unable to open setup file " + fileName;
+    return false;
+  }
+  ostringstream contents;
+  contents<<file.rdbuf();
+  return parse(contents.str(), fileName);
+}
+
+/*parse()
+ *Replaces the setup with the one in text, compiling its expressions
+ */
+bool ChannelMap::parse(const string& setupText, const string& sourceName) {
+  source = sourceName;
+  text = setupText;
+  error.clear();
+  modules.clear();
+  aliases.clear();
+  branches.clear();
+  histograms.clear();
+  gates.clear();
+  program = ParamProgram();
+
+  istringstream lines(text);
+  string line;
+  for (int number=1; getline(lines, line); number++) {
+    size_t comment = line.find('#');
+    if (comment != string::npos) line.erase(comment);
+    if (line.find_first_not_of(" \t\r") == string::npos) continue;
+    if (!statement(line)) {
+      error = source + " line " + to_string(number) + ": " + error;
+      return false;
+    }
+  }
+  if (modules.empty()) {
+    error = source + ": no modules";
+    return false;
+  }
+  return true;
+}
+
+/*statement()
+ *One non-empty line of the setup
+ */
+bool ChannelMap::statement(const string& line) {
+  istringstream words(line);
+  string keyword, name;
+  words>>keyword>>name;
+  if (keyword != "module" && keyword != "alias" && keyword != "const" && keyword != "temp" &&
+      keyword != "param" && keyword != "gate" && keyword != "hist") {
+    error = "unknown statement '" + keyword + "'";
+    return false;
+  }
+  if (!isName(name)) {
+    error = "expected a name after '" + keyword + "'";
+    return false;
+  }
+  if (keyword == "hist") return histogram(name, words);
+  if (program.isDefined(name)) {
+    error = "'" + name + "' is already defined";
+    return false;
+  }
+  for (const char* branch : {"run", "event", "nhits", "hit_module", "hit_channel", "hit_value"}) {
+    if (name == branch) {
+      error = "'" + name + "' is a branch the converter always writes";
+      return false;
+    }
+  }
+
+  if (keyword == "module") {
+    string type, extra;
+    int id = -1;
+    if (!(words>>type>>id) || (type != "adc" && type != "mtdc") || (words>>extra)) {
+      error = "expected: module NAME adc|mtdc GEO";
+      return false;
+    }
+    bool mtdc = type == "mtdc";
+    int nIds = mtdc ? mTDCUnpacker::N_IDS : ADCUnpacker::N_IDS;
+    if (id < 0 || id >= nIds) {
+      error = type + " geo/id must be 0-" + to_string(nIds-1);
+      return false;
+    }
+    for (auto& module : modules) {
+      if (module.mtdc == mtdc && module.id == id) {
+        error = "geo/id " + to_string(id) + " is already used by " + module.name;
+        return false;
+      }
+    }
+    if (modules.size() == (size_t) SETUP_MAX_MODULES) {
+      error = "more than " + to_string(SETUP_MAX_MODULES) + " modules";
+      return false;
+    }
+    program.addModule(name, modules.size());
+    modules.push_back({name, mtdc, id});
+    return true;
+  }
+
+  string equals;
+  words>>equals;
+  if (equals != "=") {
+    error = "expected '=' after '" + name + "'";
+    return false;
+  }
+  string expression;
+  getline(words, expression);
+
+  if (keyword == "alias") {
+    //MODULE[CHANNEL] and nothing else
+    size_t open = expression.find('['), close = expression.find(']');
+    string module = open == string::npos ? "" : expression.substr(0, open);
+    module.erase(0, module.find_first_not_of(" \t"));
+    module.erase(module.find_last_not_of(" \t")+1);
+    int slot = -1;
+    for (size_t i=0; i<modules.size(); i++) {
+      if (modules[i].name == module) slot = i;
+    }
+    string digits;
+    if (close != string::npos && close > open) digits = expression.substr(open+1, close-open-1);
+    if (slot < 0 || digits.empty() || digits.find_first_not_of("0123456789") != string::npos ||
+        expression.find_first_not_of(" \t\r", close+1) != string::npos) {
+      error = "expected: alias NAME = MODULE[CHANNEL]";
+      return false;
+    }
+    int channel = atoi(digits.c_str());
+    if (aliases.size() == (size_t) SETUP_MAX_ALIASES) {
+      error = "more than " + to_string(SETUP_MAX_ALIASES) + " aliases";
+      return false;
+    }
+    if (!program.addAlias(name, slot, channel, error)) return false;
+    branches.push_back({name, true, (int) aliases.size()});
+    aliases.push_back({name, slot, channel});
+    return true;
+  }
+  if (keyword == "const") return program.addConstant(name, expression, error);
+  if (keyword == "temp") return program.addParameter(name, expression, false, error);
+  if (keyword == "gate") {
+    if (gates.size() == (size_t) SETUP_MAX_GATES) {
+      error = "more than " + to_string(SETUP_MAX_GATES) + " gates";
+      return false;
+    }
+    if (!program.addGate(name, expression, error)) return false;
+    gates.push_back(name);
+    return true;
+  }
+  if (program.getOutputs() == (size_t) SETUP_MAX_PARAMS) {
+    error = "more than " + to_string(SETUP_MAX_PARAMS) + " parameters";
+    return false;
+  }
+  if (!program.addParameter(name, expression, true, error)) return false;
+  branches.push_back({name, false, (int) program.getOutputs()-1});
+  return true;
+}
+
+/*histogram()
+ *The rest of a hist statement: one or two axes of VARIABLE BINS LOW HIGH
+ */
+bool ChannelMap::histogram(const string& name, istream& words) {
+  for (auto& hist : histograms) {
+    if (hist.name == name) {
+      error = "histogram '" + name + "' is already defined";
+      return false;
+    }
+  }
+  HistSpec hist;
+  hist.name = name;
+  string variable;
+  long bins = 1;
+  while (words>>variable) {
+    HistAxis next;
+    if (hist.axes.size() == 2 || !(words>>next.bins>>next.low>>next.high)) {
+      error = "expected: hist NAME X BINS LOW HIGH [Y BINS LOW HIGH]";
+      return false;
+    }
+    if (next.bins < 1 || next.high <= next.low) {
+      error = "bad binning for " + variable;
+      return false;
+    }
+    if (!axis(variable, next)) return false;
+    bins *= next.bins;
+    hist.axes.push_back(next);
+  }
+  if (hist.axes.empty()) {
+    error = "expected: hist NAME X BINS LOW HIGH [Y BINS LOW HIGH]";
+    return false;
+  }
+  if (bins > SETUP_MAX_BINS) {
+    error = "more than " + to_string(SETUP_MAX_BINS) + " bins";
+    return false;
+  }
+  histograms.push_back(hist);
+  return true;
+}
+
+/*axis()
+ *Resolves what a histogram axis is filled with: MODULE[CHANNEL], an alias or a parameter
+ */
+bool ChannelMap::axis(const string& variable, HistAxis& axis) {
+  axis.name = variable;
+  axis.slot = axis.channel = axis.index = -1;
+  size_t open = variable.find('[');
+  if (open != string::npos) {
+    string digits = variable.substr(open+1);
+    if (!digits.empty() && digits.back() == ']') digits.pop_back();
+    for (size_t i=0; i<modules.size(); i++) {
+      if (modules[i].name == variable.substr(0, open)) axis.slot = i;
+    }
+    if (axis.slot < 0 || digits.empty() || digits.size() > 2 ||
+        digits.find_first_not_of("0123456789") != string::npos || atoi(digits.c_str()) > 31 ||
+        variable.back() != ']') {
+      error = "expected MODULE[CHANNEL] with a channel 0-31: " + variable;
+      return false;
+    }
+    axis.source = AXIS_CHANNEL;
+    axis.channel = atoi(digits.c_str());
+    return true;
+  }
+  for (auto& branch : branches) {
+    if (branch.name == variable) {
+      axis.source = branch.alias ? AXIS_ALIAS : AXIS_PARAM;
+      axis.index = branch.index;
+      return true;
+    }
+  }
+  if (program.isDefined(variable)) {
+    error = "only channels, aliases and parameters can be histogrammed: " + variable;
+  } else {
+    error = "unknown name '" + variable + "'";
+  }
+  return false;
+}
@@ -0,0 +1,110 @@
+/*ChannelMap.h
+ *The detector setup: the modules in the VME stack, named channels and the derived
+ *parameters, read at startup from a setup file (--setup) instead of being compiled in, so
+ *recabling a detector doesn't mean editing the converter. The built-in default is the SPS
+ *focal plane setup evt2root has always used; --print-setup writes it out as a starting point.
+ *
+ *Setup file, one statement per line, # to the end of the line is a comment:
+ *  module NAME adc|mtdc GEO    a module in the stack, by geo address (ADC) or id (mTDC);
+ *                              NAME is its branch, or its name in the sparse hit list
+ *  alias NAME = MODULE[CHANNEL]  an Int_t branch holding one channel
+ *  const NAME = EXPRESSION       a named number
+ *  temp NAME = EXPRESSION        an intermediate Float_t, not written
+ *  param NAME = EXPRESSION       a Float_t branch
+ *  gate NAME = EXPRESSION        events for which it is 0 are not written to the tree
+ *  hist NAME X BINS LOW HIGH [Y BINS LOW HIGH]
+ *                              a 1D or 2D histogram filled during conversion; X and Y
+ *                              are MODULE[CHANNEL], aliases or parameters
+ *Expressions are described in ParamProgram.h. Names must be declared before they are
+ *used; aliases and parameters become branches in the order they are declared.
+ *
+ *Plain types only, so the benchmark can be built without ROOT.
+ *
+ *Oct 2026
+ */
+
+#ifndef CHANNELMAP_H
+#define CHANNELMAP_H
+
+#include <string>
+#include <vector>
+#include <iosfwd>
+#include "ParamProgram.h"
+
+static const int SETUP_MAX_MODULES = 8;
+static const int SETUP_MAX_ALIASES = 32;
+static const int SETUP_MAX_PARAMS = 64;
+static const int SETUP_MAX_GATES = 32; //one bit each in SPSEvent::failedGates
+static const long SETUP_MAX_BINS = 1L<<22; //per histogram, so a 2D one stays at 32 MB/thread
+
+struct ModuleSpec {
+  std::string name;
+  bool mtdc;
+  int id; //geo address of an ADC, id of an mTDC
+};
+
+struct AliasSpec {
+  std::string name;
+  int slot; //index into the modules
+  int channel;
+};
+
+//one output branch: alias index or parameter (program output) index
+struct BranchSpec {
+  std::string name;
+  bool alias;
+  int index;
+};
+
+enum AxisSource {
+  AXIS_CHANNEL, //SPSEvent::modules[slot][channel]
+  AXIS_ALIAS,   //SPSEvent::aliases[index]
+  AXIS_PARAM    //SPSEvent::params[index]
+};
+
+struct HistAxis {
+  std::string name;
+  AxisSource source;
+  int slot, channel, index;
+  int bins;
+  double low, high;
+};
+
+struct HistSpec {
+  std::string name;
+  std::vector<HistAxis> axes; //x, and y for a 2D histogram
+};
+
+class ChannelMap {
+  public:
+    ChannelMap();
+    bool load(const std::string& fileName);
+    bool parse(const std::string& text, const std::string& sourceName);
+    static const char* defaultSetup();
+    const std::string& getError() const { return error; };
+    const std::string& getSource() const { return source; };
+    const std::string& getText() const { return text; };
+    const std::vector<ModuleSpec>& getModules() const { return modules; };
+    const std::vector<AliasSpec>& getAliases() const { return aliases; };
+    const std::vector<BranchSpec>& getBranches() const { return branches; };
+    const std::vector<HistSpec>& getHistograms() const { return histograms; };
+    const std::vector<std::string>& getGates() const { return gates; };
+    const ParamProgram& getProgram() const { return program; };
+
+  private:
+    bool statement(const std::string& line);
+    bool histogram(const std::string& name, std::istream& words);
+    bool axis(const std::string& variable, HistAxis& axis);
+
+    std::string source; //file name, or "built-in"
+    std::string text;
+    std::string error;
+    std::vector<ModuleSpec> modules;
+    std::vector<AliasSpec> aliases;
+    std::vector<BranchSpec> branches;
+    std::vector<HistSpec> histograms;
+    std::vector<std::string> gates;
+    ParamProgram program;
+};
+
+#endif
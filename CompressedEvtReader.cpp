@@ -0,0 +1,368 @@
+/*CompressedEvtReader.cpp
+ *Reads ring items straight out of a gzip, xz or zstd compressed .evt file, with the
+ *decompression on its own thread.
+ *
+ *Oct 2026
+ */
+
+#include "CompressedEvtReader.h"
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#ifdef EVT_GZ
+#include <zlib.h>
+#endif
+#ifdef EVT_XZ
+#include <lzma.h>
+#endif
+#ifdef EVT_ZSTD
+#include <zstd.h>
+#endif
+
+using namespace std;
+
+static const size_t CHUNK_SIZE = 2*1024*1024; //decompressed bytes per hand-off to the reader
+static const size_t N_CHUNKS = 4; //how far the decompression thread may run ahead
+static const size_t INPUT_SIZE = 1024*1024; //compressed bytes per read()
+
+/*Decoder
+ *One compressed file. step() decompresses as much of [in, in+inLeft) into
+ *[out, out+outLeft) as it can and advances both; inputEnded says no more input will come.
+ *Returns false on corrupt data. atEnd is true when the data so far ends exactly at the end
+ *of a gzip member, xz stream or zstd frame, i.e. the file wasn't cut short.
+ */
+struct CompressedEvtReader::Decoder {
+  virtual ~Decoder() {};
+  virtual bool step(const unsigned char*& in, size_t& inLeft, unsigned char*& out,
+                    size_t& outLeft, bool inputEnded) = 0;
+  bool ok = false;
+  bool atEnd = false;
+};
+
+#ifdef EVT_GZ
+struct GzipDecoder : public CompressedEvtReader::Decoder {
+  z_stream z;
+
+  GzipDecoder() {
+    memset(&z, 0, sizeof(z));
+    ok = inflateInit2(&z, 16+MAX_WBITS) == Z_OK; //gzip wrapper only
+  };
+  ~GzipDecoder() { inflateEnd(&z); };
+
+  bool step(const unsigned char*& in, size_t& inLeft, unsigned char*& out, size_t& outLeft,
+            bool) override {
+    if (atEnd) inflateReset(&z); //another member follows (as from pigz or cat)
+    z.next_in = (Bytef*) in;
+    z.avail_in = inLeft;
+    z.next_out = out;
+    z.avail_out = outLeft;
+    int ret = inflate(&z, Z_NO_FLUSH);
+    in = z.next_in;
+    inLeft = z.avail_in;
+    out = z.next_out;
+    outLeft = z.avail_out;
+    atEnd = ret == Z_STREAM_END;
+    return ret == Z_OK || ret == Z_STREAM_END || ret == Z_BUF_ERROR;
+  };
+};
+#endif
+
+#ifdef EVT_XZ
+struct XzDecoder : public CompressedEvtReader::Decoder {
+  lzma_stream s = LZMA_STREAM_INIT;
+
+  XzDecoder(int threads) {
+#if LZMA_VERSION >= 50040002
+    //files with several blocks (xz -T) are decoded by several threads
+    if (threads > 1) {
+      lzma_mt mt;
+      memset(&mt, 0, sizeof(mt));
+      mt.flags = LZMA_CONCATENATED;
+      mt.threads = threads;
+      mt.memlimit_threading = lzma_physmem()/4;
+      mt.memlimit_stop = UINT64_MAX;
+      ok = lzma_stream_decoder_mt(&s, &mt) == LZMA_OK;
+      return;
+    }
+#endif
+    ok = lzma_stream_decoder(&s, UINT64_MAX, LZMA_CONCATENATED) == LZMA_OK;
+  };
+  ~XzDecoder() { lzma_end(&s); };
+
+  bool step(const unsigned char*& in, size_t& inLeft, unsigned char*& out, size_t& outLeft,
+            bool inputEnded) override {
+    s.next_in = in;
+    s.avail_in = inLeft;
+    s.next_out = out;
+    s.avail_out = outLeft;
+    lzma_ret ret = lzma_code(&s, inputEnded ? LZMA_FINISH : LZMA_RUN);
+    in = s.next_in;
+    inLeft = s.avail_in;
+    out = s.next_out;
+    outLeft = s.avail_out;
+    atEnd = ret == LZMA_STREAM_END;
+    return ret == LZMA_OK || ret == LZMA_STREAM_END || ret == LZMA_BUF_ERROR;
+  };
+};
+#endif
+
+#ifdef EVT_ZSTD
+struct ZstdDecoder : public CompressedEvtReader::Decoder {
+  ZSTD_DStream* d;
+
+  ZstdDecoder() {
+    d = ZSTD_createDStream();
+    ok = d != nullptr && !ZSTD_isError(ZSTD_initDStream(d));
+  };
+  ~ZstdDecoder() { ZSTD_freeDStream(d); };
+
+  bool step(const unsigned char*& in, size_t& inLeft, unsigned char*& out, size_t& outLeft,
+            bool) override {
+    ZSTD_inBuffer input = {in, inLeft, 0};
+    ZSTD_outBuffer output = {out, outLeft, 0};
+    size_t ret = ZSTD_decompressStream(d, &output, &input);
+    in += input.pos;
+    inLeft -= input.pos;
+    out += output.pos;
+    outLeft -= output.pos;
+    if (ZSTD_isError(ret)) return false;
+    //0 once a frame is complete and flushed; the next call starts on the following frame
+    atEnd = ret == 0;
+    return true;
+  };
+};
+#endif
+
+static const char* formatName(EvtCompression compression) {
+  switch (compression) {
+    case COMPRESSION_GZIP: return "gzip";
+    case COMPRESSION_XZ: return "xz";
+    case COMPRESSION_ZSTD: return "zstd";
+    default: return "uncompressed";
+  }
+}
+
+CompressedEvtReader::CompressedEvtReader() :
+  fd(-1), nThreads(1), fileSize(0), position(0), cleanEnd(false),
+  ended(false), begin(0), end(0), truncated(false)
+{
+}
+
+CompressedEvtReader::~CompressedEvtReader() {
+  close();
+}
+
+/*compressionOf()
+ *Compression of a file, from its magic bytes; COMPRESSION_NONE for anything else,
+ *including a file that can't be read
+ */
+EvtCompression CompressedEvtReader::compressionOf(const string& name) {
+  unsigned char magic[6] = {0};
+  int file = ::open(name.c_str(), O_RDONLY);
+  if (file < 0) return COMPRESSION_NONE;
+  ssize_t n = read(file, magic, sizeof(magic));
+  ::close(file);
+  if (n >= 2 && magic[0] == 0x1f && magic[1] == 0x8b) return COMPRESSION_GZIP;
+  if (n >= 6 && !memcmp(magic, "\xfd" "7zXZ\0", 6)) return COMPRESSION_XZ;
+  if (n >= 4 && !memcmp(magic, "\x28\xb5\x2f\xfd", 4)) return COMPRESSION_ZSTD;
+  return COMPRESSION_NONE;
+}
+
+/*isSupported()
+ *Whether this build can read the given compression
+ */
+bool CompressedEvtReader::isSupported(EvtCompression compression) {
+  switch (compression) {
+#ifdef EVT_GZ
+    case COMPRESSION_GZIP: return true;
+#endif
+#ifdef EVT_XZ
+    case COMPRESSION_XZ: return true;
+#endif
+#ifdef EVT_ZSTD
+    case COMPRESSION_ZSTD: return true;
+#endif
+    default: return false;
+  }
+}
+
+/*open()
+ *Opens a compressed evt file and starts decompressing it. Returns false, with the reason
+ *in getError(), if the file can't be opened or its format isn't built in.
+ */
+bool CompressedEvtReader::open(const string& name) {
+  close();
+  error.clear();
+  EvtCompression compression = compressionOf(name);
+  if (!isSupported(compression)) {
+    if (compression == COMPRESSION_NONE) error = "not a compressed evt file: " + name;
+    else error = string("this build can't read ") + formatName(compression) + " files: " + name;
+    return false;
+  }
+  fd = ::open(name.c_str(), O_RDONLY);
+  if (fd < 0) {
+    error = "unable to open " + name;
+    return false;
+  }
+  struct stat st;
+  fileSize = fstat(fd, &st) == 0 ? st.st_size : 0;
+  posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+  switch (compression) {
+#ifdef EVT_GZ
+    case COMPRESSION_GZIP: decoder.reset(new GzipDecoder); break;
+#endif
+#ifdef EVT_XZ
+    case COMPRESSION_XZ: decoder.reset(new XzDecoder(nThreads)); break;
+#endif
+#ifdef EVT_ZSTD
+    case COMPRESSION_ZSTD: decoder.reset(new ZstdDecoder); break;
+#endif
+    default: break;
+  }
+  if (!decoder || !decoder->ok) {
+    error = string("unable to start the ") + formatName(compression) + " decoder";
+    close();
+    return false;
+  }
+
+  chunks.resize(N_CHUNKS);
+  full.reset(new SPSCQueue<Chunk*>(N_CHUNKS+1)); //room for the end marker too
+  empty.reset(new SPSCQueue<Chunk*>(N_CHUNKS));
+  for (auto& chunk : chunks) {
+    chunk.data.resize(CHUNK_SIZE);
+    empty->push(&chunk);
+  }
+  buffer.resize(2*CHUNK_SIZE);
+  begin = end = 0;
+  position = 0;
+  cleanEnd = false;
+  ended = false;
+  truncated = false;
+  worker = thread(&CompressedEvtReader::decompress, this);
+  return true;
+}
+
+void CompressedEvtReader::close() {
+  //wakes the worker if it is waiting on a queue, and makes it return at the next hand-off
+  if (full) full->close();
+  if (empty) empty->close();
+  if (worker.joinable()) worker.join();
+  decoder.reset();
+  if (fd >= 0) ::close(fd);
+  fd = -1;
+  begin = end = 0;
+  truncated = false;
+}
+
+/*decompress()
+ *Decompression thread: fills empty chunks and hands them to the reader in order, then
+ *sends a null chunk to mark the end of the data. Stops early when close() closes the queues.
+ */
+void CompressedEvtReader::decompress() {
+  vector<unsigned char> input(INPUT_SIZE);
+  const unsigned char* in = input.data();
+  size_t inLeft = 0;
+  uint64_t bytesRead = 0;
+  bool inputEnded = false, finished = false, failed = false;
+  while (!finished) {
+    Chunk* chunk;
+    if (!empty->pop(chunk)) return;
+    unsigned char* out = (unsigned char*) chunk->data.data();
+    size_t outLeft = chunk->data.size();
+    while (outLeft > 0) {
+      if (inLeft == 0 && !inputEnded) {
+        ssize_t n = read(fd, input.data(), input.size());
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) {
+          error = string("read error: ") + strerror(errno);
+          failed = true;
+        }
+        inputEnded = n <= 0;
+        in = input.data();
+        inLeft = n > 0 ? n : 0;
+        bytesRead += inLeft;
+      }
+      if (failed || (inputEnded && inLeft == 0 && decoder->atEnd)) {
+        finished = true;
+        break;
+      }
+      size_t inBefore = inLeft, outBefore = outLeft;
+      if (!decoder->step(in, inLeft, out, outLeft, inputEnded)) {
+        error = "corrupt compressed data";
+        failed = finished = true;
+        break;
+      }
+      //nothing left to read and the decoder is stuck: the file was cut short
+      if (inputEnded && inLeft == inBefore && outLeft == outBefore) {
+        finished = true;
+        break;
+      }
+    }
+    chunk->n = chunk->data.size() - outLeft;
+    chunk->position = bytesRead - inLeft;
+    if (chunk->n == 0) break;
+    if (!full->push(chunk)) return;
+  }
+  cleanEnd = !failed && decoder->atEnd;
+  full->push(nullptr);
+}
+
+/*fill()
+ *Appends the next decompressed chunk to the buffer, first moving the unread bytes to the
+ *front. Returns false at the end of the data.
+ */
+bool CompressedEvtReader::fill() {
+  if (ended) return false;
+  if (begin > 0) {
+    memmove(buffer.data(), buffer.data()+begin, end-begin);
+    end -= begin;
+    begin = 0;
+  }
+  Chunk* chunk = nullptr;
+  full->pop(chunk);
+  if (chunk == nullptr) {
+    ended = true;
+    return false;
+  }
+  if (end + chunk->n > buffer.size()) buffer.resize(end + chunk->n);
+  memcpy(buffer.data()+end, chunk->data.data(), chunk->n);
+  end += chunk->n;
+  position = chunk->position;
+  empty->push(chunk);
+  return true;
+}
+
+/*next()
+ *Points item at the next complete ring item. Returns false at the end of the data;
+ *isTruncated() then tells whether the file was cut short, either part way through a ring
+ *item or part way through the compressed stream, and getError() says why.
+ */
+bool CompressedEvtReader::next(RingItem& item) {
+  if (fd < 0) return false;
+  while (true) {
+    if (end-begin >= 8) {
+      uint32_t header[2];
+      memcpy(header, buffer.data()+begin, 8);
+      if (header[0] < 8 || header[0] > MAX_RING_SIZE) {
+        truncated = true;
+        if (error.empty()) error = "corrupt ring item size";
+        return false;
+      }
+      if (header[0] <= end-begin) {
+        item.size = header[0];
+        item.type = header[1];
+        item.body = buffer.data()+begin+8;
+        begin += header[0];
+        return true;
+      }
+    }
+    if (!fill()) {
+      truncated = end != begin || !cleanEnd;
+      if (!cleanEnd && error.empty()) error = "compressed data ends early";
+      return false;
+    }
+  }
+}
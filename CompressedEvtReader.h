@@ -0,0 +1,83 @@
+/*CompressedEvtReader.h
+ *Reads ring items straight out of a compressed .evt file (gzip, xz or zstd), so archived
+ *runs don't have to be unpacked to scratch disk first. The format is recognised from the
+ *file's magic bytes, whatever the name. Concatenated gzip members, xz streams and zstd
+ *frames are all read through.
+ *
+ *Decompression runs on its own thread, a few MB ahead of the reader, so it overlaps with
+ *unpacking. xz files written with several blocks (xz -T) can also be decoded by several
+ *threads, see setThreads().
+ *
+ *Each format is only built in when the Makefile finds its library (EVT_GZ, EVT_XZ,
+ *EVT_ZSTD); open() fails with an explanation for one that isn't.
+ *
+ *A ring item handed out by next() is only valid until the following call.
+ *
+ *Oct 2026
+ */
+
+#ifndef COMPRESSEDEVTREADER_H
+#define COMPRESSEDEVTREADER_H
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include "RingSource.h"
+#include "SPSCQueue.h"
+
+enum EvtCompression {
+  COMPRESSION_NONE,
+  COMPRESSION_GZIP,
+  COMPRESSION_XZ,
+  COMPRESSION_ZSTD
+};
+
+class CompressedEvtReader : public RingSource {
+  public:
+    CompressedEvtReader();
+    ~CompressedEvtReader();
+    static EvtCompression compressionOf(const std::string& name);
+    static bool isSupported(EvtCompression compression);
+    void setThreads(int n) { nThreads = n > 0 ? n : 1; };
+    bool open(const std::string& name);
+    void close();
+    bool next(RingItem& item) override;
+    bool isTruncated() override { return truncated; };
+    std::uint64_t getPosition() override { return position; };
+    std::uint64_t getSize() { return fileSize; };
+    const std::string& getError() { return error; };
+
+    struct Decoder; //format-specific streaming decompressor, see CompressedEvtReader.cpp
+
+  private:
+    CompressedEvtReader(const CompressedEvtReader&) = delete;
+    CompressedEvtReader& operator=(const CompressedEvtReader&) = delete;
+    struct Chunk {
+      std::vector<char> data;
+      std::size_t n = 0;
+      std::uint64_t position = 0; //compressed bytes decoded up to the end of this chunk
+    };
+    void decompress();
+    bool fill();
+
+    int fd;
+    int nThreads;
+    std::uint64_t fileSize;
+    std::unique_ptr<Decoder> decoder;
+    std::thread worker;
+    std::vector<Chunk> chunks;
+    //decompressed chunks go worker -> reader in full, and back in empty
+    std::unique_ptr<SPSCQueue<Chunk*>> full, empty;
+    std::uint64_t position; //compressed bytes behind the chunks handed to the reader
+    bool cleanEnd; //set by the worker before its end marker: the last stream was complete
+    std::string error;
+    bool ended;
+    std::vector<char> buffer;
+    std::size_t begin, end; //unread bytes are [begin, end) of buffer
+    bool truncated;
+};
+
+#endif
@@ -0,0 +1,207 @@
+/*EvtGenerator.cpp
+ *Writes synthetic NSCLDAQ 11 data; see EvtGenerator.h
+ *
+ *Oct 2026
+ */
+
+#include "EvtGenerator.h"
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+using namespace std;
+
+static const int ADC_GEOS[4] = {3, 4, 5, 8};
+static const int MTDC_ID = 9;
+static const int STRAY_GEO = 12; //a geo address that isn't in the stack
+static const size_t WRITE_CHUNK = 1<<20;
+
+static void put16(vector<char>& out, uint16_t w) {
+  out.push_back(w & 0xff);
+  out.push_back(w >> 8);
+}
+
+static void put32(vector<char>& out, uint32_t w) {
+  put16(out, w & 0xffff);
+  put16(out, w >> 16);
+}
+
+static void push32(vector<uint16_t>& words, uint32_t w) {
+  words.push_back(w & 0xffff); //low half first
+  words.push_back(w >> 16);
+}
+
+//ring item size is only known once the body is written
+static void patchSize(vector<char>& out, size_t start) {
+  uint32_t size = out.size() - start;
+  for (int i=0; i<4; i++) out[start+i] = (size >> 8*i) & 0xff;
+}
+
+EvtGenerator::EvtGenerator(uint64_t seed) : rng(seed) {
+}
+
+/*ringHeader()
+ *Ring item header (size patched later) and body header. With body headers on, the
+ *timestamp counts events and the barrier type marks state changes, as from the event
+ *builder; otherwise the body header is the single zero word of NSCLDAQ 11.0.
+ */
+void EvtGenerator::ringHeader(vector<char>& out, uint32_t type, uint32_t barrier) {
+  put32(out, 0);
+  put32(out, type);
+  if (bodyHeaders) {
+    put32(out, 20); //size of the body header, this word included
+    put32(out, (uint32_t) nEvents); //64 bit timestamp
+    put32(out, (uint32_t) (nEvents >> 32));
+    put32(out, 0); //source id
+    put32(out, barrier);
+  } else {
+    put32(out, 0);
+  }
+}
+
+/*stateChange()
+ *BEGIN_RUN / END_RUN body: run number, seconds into the run, a zero clock time (so the
+ *output stays reproducible), offset divisor and the 81 byte title.
+ */
+void EvtGenerator::stateChange(vector<char>& out, uint32_t type, uint32_t elapsed) {
+  size_t start = out.size();
+  ringHeader(out, type, type);
+  put32(out, run);
+  put32(out, elapsed);
+  put32(out, 0);
+  put32(out, 1);
+  char title[81] = "evtgen synthetic run";
+  out.insert(out.end(), title, title+sizeof(title));
+  patchSize(out, start);
+}
+
+void EvtGenerator::beginRun(vector<char>& out) {
+  stateChange(out, 1, 0);
+}
+
+void EvtGenerator::endRun(vector<char>& out) {
+  stateChange(out, 2, nEvents/1000);
+}
+
+/*physics()
+ *Appends one complete PHYSICS_EVENT ring item
+ */
+void EvtGenerator::physics(vector<char>& out) {
+  size_t start = out.size();
+  ringHeader(out, 30, 0);
+  body.clear();
+  physicsBody(body);
+  for (uint16_t w : body) put16(out, w);
+  patchSize(out, start);
+}
+
+/*physicsBody()
+ *Appends one physics body as 16-bit words: the word count, then a block from each ADC
+ *and the mTDC with multiplicity distinct channels each, every block followed by gap
+ *filler words. Each event is corrupted with probability corruption.
+ */
+void EvtGenerator::physicsBody(vector<uint16_t>& words) {
+  size_t start = words.size();
+  words.push_back(0); //word count, filled below
+  vector<size_t> blocks;
+  uint32_t counter = nEvents;
+  int channels[32];
+  //multiplicity distinct channels, in readout order
+  auto pick = [&]() {
+    for (int i=0; i<32; i++) channels[i] = i;
+    for (int i=0; i<multiplicity; i++) swap(channels[i], channels[i + rng()%(32-i)]);
+    sort(channels, channels+multiplicity);
+  };
+
+  for (int geo : ADC_GEOS) {
+    blocks.push_back(words.size());
+    pick();
+    push32(words, geo<<27 | 0x2<<24 | multiplicity<<8);
+    for (int i=0; i<multiplicity; i++) push32(words, geo<<27 | channels[i]<<16 | rng()%4096);
+    push32(words, geo<<27 | 0x4<<24 | (counter & 0xffffff));
+    words.insert(words.end(), gap, 0x0000);
+  }
+  blocks.push_back(words.size());
+  pick();
+  push32(words, 0x40000000 | MTDC_ID<<16 | (multiplicity+1));
+  for (int i=0; i<multiplicity; i++) push32(words, 0x04000000 | channels[i]<<16 | rng()%65536);
+  push32(words, 0xc0000000 | (counter & 0x3fffffff));
+  words.insert(words.end(), gap, 0x0000);
+  words[start] = words.size()-start-1;
+
+  if (corruption > 0 && (rng() >> 11)*0x1.0p-53 < corruption) {
+    corrupt(words, start, blocks);
+    nCorrupted++;
+  }
+  nEvents++;
+}
+
+/*corrupt()
+ *Damages the physics body at start in one of six ways, chosen at random
+ */
+void EvtGenerator::corrupt(vector<uint16_t>& words, size_t start, const vector<size_t>& blocks) {
+  size_t b = rng()%blocks.size();
+  bool mtdc = b+1 == blocks.size(); //the mTDC block is last
+  size_t block = blocks[b];
+  size_t blockEnd = mtdc ? words.size() : blocks[b+1];
+  switch (rng()%6) {
+    case 0: //a flipped bit anywhere in the module data
+      words[start+1 + rng()%(words.size()-start-1)] ^= 1u << rng()%16;
+      break;
+    case 1: //block lost its end-of-event word
+      words.erase(words.begin()+blockEnd-gap-2, words.begin()+blockEnd-gap);
+      break;
+    case 2: //header claims more data words than the block has
+      words[block] |= mtdc ? 0x03ff : 0x3f00;
+      break;
+    case 3: //physics item word count runs past the end of the ring item
+      words[start] = 0xffff;
+      return;
+    case 4: //block from a module that isn't in the stack
+      push32(words, STRAY_GEO<<27 | 0x2<<24 | 1<<8);
+      push32(words, STRAY_GEO<<27 | (rng()%4096));
+      push32(words, STRAY_GEO<<27 | 0x4<<24 | (nEvents & 0xffffff));
+      break;
+    case 5: //word count just one word more than the ring item holds
+      words[start] = words.size()-start;
+      return;
+  }
+  words[start] = words.size()-start-1;
+}
+
+/*write()
+ *Writes a BEGIN_RUN item, nPhysics physics items and an END_RUN item to name, or to
+ *stdout for "-". With maxBytes set, stops early at the last physics item that fits in
+ *maxBytes (nPhysics 0 then means no limit on the count). Returns false if the file
+ *can't be written.
+ */
+bool EvtGenerator::write(const string& name, uint64_t nPhysics, uint64_t maxBytes) {
+  FILE* file = name == "-" ? stdout : fopen(name.c_str(), "wb");
+  if (file == nullptr) return false;
+  vector<char> out;
+  out.reserve(2*WRITE_CHUNK);
+  uint64_t bytes = 0;
+  bool ok = true;
+  beginRun(out);
+  for (uint64_t i=0; ok && (nPhysics > 0 ? i<nPhysics : maxBytes > 0); i++) {
+    size_t before = out.size();
+    uint64_t corruptedBefore = nCorrupted;
+    physics(out);
+    if (maxBytes > 0 && bytes + out.size() > maxBytes) {
+      //doesn't fit; take it back
+      out.resize(before);
+      nEvents--;
+      nCorrupted = corruptedBefore;
+      break;
+    }
+    if (out.size() >= WRITE_CHUNK) {
+      ok = fwrite(out.data(), 1, out.size(), file) == out.size();
+      bytes += out.size();
+      out.clear();
+    }
+  }
+  endRun(out);
+  ok = ok && fwrite(out.data(), 1, out.size(), file) == out.size();
+  ok = (file == stdout ? fflush(file) : fclose(file)) == 0 && ok;
+  return ok;
+}
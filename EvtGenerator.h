@@ -0,0 +1,57 @@
+/*EvtGenerator.h
+ *Writes synthetic NSCLDAQ 11 data: a BEGIN_RUN item, physics items and an END_RUN item.
+ *Each physics item carries the SPS stack (ADCs at geo 3/4/5/8 and the mTDC at id 9) as
+ *module blocks in the reversed 16-bit layout the unpackers expect, with a set number of
+ *channels fired per module. A fraction of the events can be corrupted in the ways real
+ *data goes wrong (flipped bits, missing end-of-event words, overrunning counts, physics
+ *items whose word count runs past the ring, blocks from a module not in the stack), so
+ *the error paths and counters get exercised too.
+ *
+ *Output depends only on the seed and the settings, so the same file can be regenerated
+ *anywhere. Used by evtgen, bench and evt2root --benchmark.
+ *
+ *Oct 2026
+ */
+
+#ifndef EVTGENERATOR_H
+#define EVTGENERATOR_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <random>
+
+class EvtGenerator {
+  public:
+    EvtGenerator(std::uint64_t seed = 1);
+    void setRun(std::uint32_t r) { run = r; };
+    void setMultiplicity(int m) { multiplicity = m < 0 ? 0 : (m > 32 ? 32 : m); };
+    void setGap(int words) { gap = words > 0 ? words : 0; };
+    void setCorruption(double p) { corruption = p; };
+    void setBodyHeaders(bool on) { bodyHeaders = on; };
+    bool write(const std::string& name, std::uint64_t nPhysics, std::uint64_t maxBytes = 0);
+    void beginRun(std::vector<char>& out);
+    void endRun(std::vector<char>& out);
+    void physics(std::vector<char>& out);
+    void physicsBody(std::vector<std::uint16_t>& words);
+    std::uint64_t getEvents() { return nEvents; };
+    std::uint64_t getCorrupted() { return nCorrupted; };
+
+  private:
+    void stateChange(std::vector<char>& out, std::uint32_t type, std::uint32_t elapsed);
+    void ringHeader(std::vector<char>& out, std::uint32_t type, std::uint32_t barrier);
+    void corrupt(std::vector<std::uint16_t>& words, std::size_t start,
+                 const std::vector<std::size_t>& blocks);
+
+    std::mt19937_64 rng;
+    std::uint32_t run = 1;
+    int multiplicity = 4; //channels fired per module per event
+    int gap = 0; //filler words after each module block
+    double corruption = 0; //fraction of physics events corrupted
+    bool bodyHeaders = true;
+    std::uint64_t nEvents = 0;
+    std::uint64_t nCorrupted = 0;
+    std::vector<std::uint16_t> body; //scratch for one physics body
+};
+
+#endif
@@ -0,0 +1,132 @@
+/*EvtIndex.cpp
+ *Side-car index of an .evt file: byte offsets of every ring item by ring type.
+ *
+ *Oct 2026
+ */
+
+#include "EvtIndex.h"
+#include "EvtReader.h"
+#include <sys/stat.h>
+#include <cstdio>
+#include <cstring>
+
+using namespace std;
+
+static const char INDEX_MAGIC[8] = {'E','V','T','I','D','X','1','\0'};
+
+EvtIndex::EvtIndex() :
+  fileSize(0), modified(0)
+{
+}
+
+/*stamp()
+ *Size and modification time of the evt file, used to tell whether an index is current
+ */
+bool EvtIndex::stamp(const string& evtName, uint64_t& size, int64_t& mtime) const {
+  struct stat st;
+  if (stat(evtName.c_str(), &st) != 0) return false;
+  size = st.st_size;
+  mtime = (int64_t)st.st_mtim.tv_sec*1000000000 + st.st_mtim.tv_nsec;
+  return true;
+}
+
+/*open()
+ *Loads the side-car index if it matches the evt file, otherwise builds it and tries to
+ *save it. Returns false only if the evt file itself cannot be read.
+ */
+bool EvtIndex::open(const string& evtName) {
+  if (load(evtName)) return true;
+  if (!build(evtName)) return false;
+  save(evtName);//an unwritable directory just means rebuilding next time
+  return true;
+}
+
+/*build()
+ *Walks the ring headers of the evt file. Stops at the first incomplete item, so a
+ *truncated file is indexed up to the last complete ring item.
+ */
+bool EvtIndex::build(const string& evtName) {
+  items.clear();
+  if (!stamp(evtName, fileSize, modified)) return false;
+  EvtReader reader;
+  if (!reader.open(evtName)) return false;
+  RingItem ring;
+  uint64_t offset = reader.getPosition();
+  vector<uint64_t>* physics = &items[30];//by far the most common; skip the map lookup
+  while (reader.next(ring)) {
+    if (ring.type == 30) physics->push_back(offset);
+    else items[ring.type].push_back(offset);
+    offset = reader.getPosition();
+  }
+  return true;
+}
+
+/*load()
+ *Reads <evt file>.idx. Returns false if it is missing, unreadable, or was built from a
+ *different version of the evt file.
+ */
+bool EvtIndex::load(const string& evtName) {
+  uint64_t size;
+  int64_t mtime;
+  if (!stamp(evtName, size, mtime)) return false;
+  FILE* file = fopen(indexName(evtName).c_str(), "rb");
+  if (file == nullptr) return false;
+
+  char magic[8];
+  uint64_t indexSize = 0;
+  int64_t indexTime = 0;
+  uint32_t nTypes = 0;
+  bool ok = fread(magic, 8, 1, file) == 1 && memcmp(magic, INDEX_MAGIC, 8) == 0 &&
+            fread(&indexSize, 8, 1, file) == 1 && fread(&indexTime, 8, 1, file) == 1 &&
+            indexSize == size && indexTime == mtime && fread(&nTypes, 4, 1, file) == 1;
+  items.clear();
+  for (uint32_t i=0; ok && i<nTypes; i++) {
+    uint32_t type;
+    uint64_t count;
+    ok = fread(&type, 4, 1, file) == 1 && fread(&count, 8, 1, file) == 1 && count <= size/8;
+    if (!ok) break;
+    vector<uint64_t>& offsets = items[type];
+    offsets.resize(count);
+    ok = count == 0 || fread(offsets.data(), 8, count, file) == count;
+  }
+  fclose(file);
+  if (!ok) {
+    items.clear();
+    return false;
+  }
+  fileSize = size;
+  modified = mtime;
+  return true;
+}
+
+/*save()
+ *Writes the index next to the evt file: magic, evt size, evt mtime, number of types,
+ *then (type, count, offsets[count]) for each type.
+ */
+bool EvtIndex::save(const string& evtName) const {
+  string name = indexName(evtName);
+  string partial = name + ".part";
+  FILE* file = fopen(partial.c_str(), "wb");
+  if (file == nullptr) return false;
+  uint32_t nTypes = items.size();
+  bool ok = fwrite(INDEX_MAGIC, 8, 1, file) == 1 && fwrite(&fileSize, 8, 1, file) == 1 &&
+            fwrite(&modified, 8, 1, file) == 1 && fwrite(&nTypes, 4, 1, file) == 1;
+  for (auto& type : items) {
+    if (!ok) break;
+    uint64_t count = type.second.size();
+    ok = fwrite(&type.first, 4, 1, file) == 1 && fwrite(&count, 8, 1, file) == 1 &&
+         (count == 0 || fwrite(type.second.data(), 8, count, file) == count);
+  }
+  ok = fclose(file) == 0 && ok;
+  if (!ok || rename(partial.c_str(), name.c_str()) != 0) {
+    remove(partial.c_str());
+    return false;
+  }
+  return true;
+}
+
+const vector<uint64_t>& EvtIndex::getOffsets(uint32_t type) const {
+  static const vector<uint64_t> none;
+  auto found = items.find(type);
+  return found == items.end() ? none : found->second;
+}
@@ -0,0 +1,39 @@
+/*EvtIndex.h
+ *Side-car index of an .evt file: the byte offset of every ring item, grouped by ring
+ *type (1 = BEGIN_RUN, 2 = END_RUN, 30 = PHYSICS_EVENT, ...). It is built with one pass
+ *that only reads the 8-byte ring headers and is stored next to the evt file as
+ *<evt file>.idx, along with the evt file's size and modification time so a stale index
+ *is rebuilt rather than used.
+ *
+ *Oct 2026
+ */
+
+#ifndef EVTINDEX_H
+#define EVTINDEX_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+
+class EvtIndex {
+  public:
+    EvtIndex();
+    bool open(const std::string& evtName);
+    bool build(const std::string& evtName);
+    bool load(const std::string& evtName);
+    bool save(const std::string& evtName) const;
+    const std::vector<std::uint64_t>& getOffsets(std::uint32_t type) const;
+    const std::map<std::uint32_t, std::vector<std::uint64_t>>& getTypes() const { return items; };
+    std::uint64_t getFileSize() const { return fileSize; };
+    static std::string indexName(const std::string& evtName) { return evtName + ".idx"; };
+
+  private:
+    bool stamp(const std::string& evtName, std::uint64_t& size, std::int64_t& mtime) const;
+
+    std::map<std::uint32_t, std::vector<std::uint64_t>> items; //ring type -> offsets
+    std::uint64_t fileSize;
+    std::int64_t modified; //ns since the epoch
+};
+
+#endif
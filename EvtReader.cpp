@@ -0,0 +1,123 @@
+/*EvtReader.cpp
+ *Memory-mapped reader for NSCLDAQ 11 .evt files. Each file is mapped read-only and
+ *ring items are handed out as pointers directly into the mapping, so there is no copy
+ *of the ring body and no large stack buffer per item.
+ *
+ *Oct 2026
+ */
+
+#include "EvtReader.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstring>
+
+using namespace std;
+
+//Drop pages we are done with in chunks of this size; keeps the mapping from pinning
+//the whole file in our resident set on multi-GB segments
+static const size_t RELEASE_CHUNK = 64*1024*1024;
+
+EvtReader::EvtReader() :
+  fd(-1), map(nullptr), mapSize(0), pos(0), limit(0), released(0), truncated(false)
+{
+}
+
+EvtReader::~EvtReader() {
+  close();
+}
+
+/*open()
+ *Maps the whole file and tells the kernel we will walk it front to back.
+ *Returns false if the file cannot be opened or mapped.
+ */
+bool EvtReader::open(const string& name) {
+  close();
+  fd = ::open(name.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close();
+    return false;
+  }
+  mapSize = st.st_size;
+  limit = mapSize;
+  if (mapSize == 0) return true; //nothing to map, but a valid (empty) file
+
+  void* addr = mmap(nullptr, mapSize, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (addr == MAP_FAILED) {
+    close();
+    return false;
+  }
+  map = (const char*) addr;
+  madvise(addr, mapSize, MADV_SEQUENTIAL);
+  madvise(addr, mapSize < RELEASE_CHUNK ? mapSize : RELEASE_CHUNK, MADV_WILLNEED);
+  return true;
+}
+
+void EvtReader::close() {
+  if (map != nullptr) munmap((void*) map, mapSize);
+  if (fd >= 0) ::close(fd);
+  fd = -1;
+  map = nullptr;
+  mapSize = 0;
+  pos = 0;
+  limit = 0;
+  released = 0;
+  truncated = false;
+}
+
+/*setRange()
+ *Restricts the reader to the ring items in [begin, end) of the file. begin must be the
+ *offset of a ring item (from an EvtIndex); end is clamped to the file size.
+ */
+bool EvtReader::setRange(size_t begin, size_t end) {
+  if (map == nullptr || begin > mapSize) return false;
+  pos = begin;
+  limit = end < mapSize ? end : mapSize;
+  if (limit < pos) limit = pos;
+  released = pos - pos%sysconf(_SC_PAGESIZE);
+  size_t len = limit-released < RELEASE_CHUNK ? limit-released : RELEASE_CHUNK;
+  madvise((void*)(map+released), len, MADV_WILLNEED);
+  return true;
+}
+
+/*next()
+ *Points item at the next ring item in the mapping. Returns false at end of file, or if
+ *the remaining bytes do not hold a complete ring item (flagged by isTruncated()).
+ */
+bool EvtReader::next(RingItem& item) {
+  if (map == nullptr || pos + 8 > limit) {
+    truncated = (map != nullptr && pos < limit);
+    return false;
+  }
+  uint32_t header[2];
+  memcpy(header, map+pos, 8);
+  if (header[0] < 8 || header[0] > limit - pos) {
+    truncated = true;
+    return false;
+  }
+  item.size = header[0];
+  item.type = header[1];
+  item.body = map + pos + 8;
+  pos += header[0];
+  if (pos - released > 2*RELEASE_CHUNK) release(pos - RELEASE_CHUNK);
+  return true;
+}
+
+/*release()
+ *Hands already-consumed pages back to the kernel and prefetches the next chunk.
+ *Only whole pages strictly behind the reader are dropped.
+ */
+void EvtReader::release(size_t upTo) {
+  size_t page = sysconf(_SC_PAGESIZE);
+  upTo -= upTo%page;
+  if (upTo <= released) return;
+  madvise((void*)(map+released), upTo-released, MADV_DONTNEED);
+  released = upTo;
+  size_t ahead = pos - pos%page;
+  size_t len = mapSize-ahead < RELEASE_CHUNK ? mapSize-ahead : RELEASE_CHUNK;
+  madvise((void*)(map+ahead), len, MADV_WILLNEED);
+}
@@ -0,0 +1,47 @@
+/*EvtReader.h
+ *Memory-mapped reader for NSCLDAQ 11 .evt files. Each file is mapped read-only and
+ *ring items are handed out as pointers directly into the mapping, so there is no copy
+ *of the ring body and no large stack buffer per item.
+ *
+ *Ring items stay valid until the reader is closed.
+ *
+ *Oct 2026
+ */
+
+#ifndef EVTREADER_H
+#define EVTREADER_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include "RingSource.h"
+
+class EvtReader : public RingSource {
+  public:
+    EvtReader();
+    ~EvtReader();
+    bool open(const std::string& name);
+    void close();
+    bool setRange(std::size_t begin, std::size_t end);
+    bool next(RingItem& item) override;
+    bool isOpen() { return map != nullptr || fd >= 0; };
+    bool isTruncated() override { return truncated; };
+    std::size_t getSize() { return mapSize; };
+    std::uint64_t getPosition() override { return pos; };
+    bool stableItems() override { return true; };
+
+  private:
+    EvtReader(const EvtReader&) = delete;
+    EvtReader& operator=(const EvtReader&) = delete;
+    void release(std::size_t upTo);
+
+    int fd;
+    const char* map;
+    std::size_t mapSize;
+    std::size_t pos;
+    std::size_t limit; //next() stops here; the end of the file unless setRange() was used
+    std::size_t released; //pages before this offset have been handed back to the kernel
+    bool truncated;
+};
+
+#endif
@@ -0,0 +1,135 @@
+/*EvtStream.cpp
+ *Buffered reader for ring items that are still being written: a .evt file NSCLDAQ is
+ *appending to, a FIFO or stdin ("-").
+ *
+ *Oct 2026
+ */
+
+#include "EvtStream.h"
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <cerrno>
+#include <cstring>
+#include <cstdint>
+#include <chrono>
+
+using namespace std;
+
+static const size_t READ_CHUNK = 4*1024*1024;
+static const int POLL_MS = 250; //how often we look for new data when there is none
+
+EvtStream::EvtStream() :
+  fd(-1), ownFd(false), isFile(false), follow(false), idleSeconds(0), stop(nullptr),
+  begin(0), end(0), truncated(false), bytesRead(0)
+{
+}
+
+EvtStream::~EvtStream() {
+  close();
+}
+
+/*open()
+ *Opens a file or FIFO by name, or stdin for "-". Returns false if it cannot be opened.
+ */
+bool EvtStream::open(const string& name) {
+  close();
+  if (name == "-") {
+    fd = STDIN_FILENO;
+    ownFd = false;
+  } else {
+    fd = ::open(name.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    ownFd = true;
+  }
+  struct stat st;
+  isFile = fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+  bytesRead = 0;
+  buffer.resize(READ_CHUNK);
+  return true;
+}
+
+void EvtStream::close() {
+  if (fd >= 0 && ownFd) ::close(fd);
+  fd = -1;
+  begin = end = 0;
+  truncated = false;
+}
+
+/*fill()
+ *Reads more data onto the end of the buffer, first moving the unread bytes to the front
+ *and growing the buffer if a single ring item needs it (next() has already checked its
+ *size against MAX_RING_SIZE). Returns false when no more data will come.
+ */
+bool EvtStream::fill() {
+  if (begin > 0) {
+    memmove(buffer.data(), buffer.data()+begin, end-begin);
+    end -= begin;
+    begin = 0;
+  }
+  if (end >= 8) {
+    uint32_t size;
+    memcpy(&size, buffer.data(), 4);
+    if (size > buffer.size()) buffer.resize(size);
+  }
+  if (end == buffer.size()) buffer.resize(2*buffer.size());
+
+  auto lastData = chrono::steady_clock::now();
+  while (stop == nullptr || !*stop) {
+    struct pollfd pfd = {fd, POLLIN, 0};
+    int ready = poll(&pfd, 1, POLL_MS);
+    if (ready > 0) {
+      ssize_t n = read(fd, buffer.data()+end, buffer.size()-end);
+      if (n > 0) {
+        end += n;
+        bytesRead += n;
+        return true;
+      }
+      if (n < 0 && errno != EINTR && errno != EAGAIN) return false;
+      //end of data: a FIFO's writer has gone, a regular file may still grow
+      if (n == 0 && (!follow || !isFile)) return false;
+      if (n == 0) usleep(POLL_MS*1000);
+    } else if (ready < 0 && errno != EINTR) {
+      return false;
+    }
+    if (!follow) continue; //a plain stream just waits for its writer
+    if (idleSeconds > 0 &&
+        chrono::duration<double>(chrono::steady_clock::now()-lastData).count() > idleSeconds) {
+      return false;
+    }
+    if (onIdle) onIdle();
+  }
+  return false;
+}
+
+/*next()
+ *Points item at the next complete ring item, reading (and in follow mode waiting) for
+ *more data as needed. Returns false at the end of the data; isTruncated() then tells
+ *whether a partial ring item was left over. A size field under 8 or over MAX_RING_SIZE
+ *also ends the stream as truncated, rather than waiting for an item that will never come.
+ */
+bool EvtStream::next(RingItem& item) {
+  if (fd < 0) return false;
+  while (true) {
+    if (end-begin >= 8) {
+      uint32_t header[2];
+      memcpy(header, buffer.data()+begin, 8);
+      if (header[0] < 8 || header[0] > MAX_RING_SIZE) {//corrupt, or a writer started mid-item
+        truncated = true;
+        return false;
+      }
+      if (header[0] <= end-begin) {
+        item.size = header[0];
+        item.type = header[1];
+        item.body = buffer.data()+begin+8;
+        begin += header[0];
+        return true;
+      }
+    }
+    if (!fill()) {
+      truncated = (end != begin);
+      return false;
+    }
+  }
+}
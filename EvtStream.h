@@ -0,0 +1,58 @@
+/*EvtStream.h
+ *Buffered reader for ring items that are still being written: a .evt file NSCLDAQ is
+ *appending to, a FIFO or stdin ("-"). A partial ring item at the end of the data read so
+ *far is kept until the rest of it arrives.
+ *
+ *In follow mode, reaching the end of a regular file means waiting for it to grow.
+ *Reading stops when the stop flag is raised, when no data has arrived for the idle time
+ *(if set), or when the writer closes a FIFO/stdin. While waiting the idle callback is
+ *called a few times a second, so the caller can flush its output.
+ *
+ *A ring item handed out by next() is only valid until the following call.
+ *
+ *Oct 2026
+ */
+
+#ifndef EVTSTREAM_H
+#define EVTSTREAM_H
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+#include "RingSource.h"
+
+class EvtStream : public RingSource {
+  public:
+    EvtStream();
+    ~EvtStream();
+    bool open(const std::string& name);
+    void close();
+    bool next(RingItem& item) override;
+    bool isTruncated() override { return truncated; };
+    std::uint64_t getPosition() override { return bytesRead; };
+    void setFollow(bool on, double idle = 0) { follow = on; idleSeconds = idle; };
+    void setStopFlag(const std::atomic<bool>* flag) { stop = flag; };
+    void setIdleCallback(std::function<void()> callback) { onIdle = callback; };
+
+  private:
+    EvtStream(const EvtStream&) = delete;
+    EvtStream& operator=(const EvtStream&) = delete;
+    bool fill();
+
+    int fd;
+    bool ownFd; //false for stdin
+    bool isFile; //regular file: end of data may just mean the writer hasn't caught up
+    bool follow;
+    double idleSeconds; //0 waits forever
+    const std::atomic<bool>* stop;
+    std::function<void()> onIdle;
+    std::vector<char> buffer;
+    std::size_t begin, end; //unread bytes are [begin, end) of buffer
+    bool truncated;
+    std::uint64_t bytesRead;
+};
+
+#endif
@@ -0,0 +1,67 @@
+/*Histograms.cpp
+ *Booking, filling and merging of the setup's histograms; see Histograms.h
+ *
+ *Oct 2026
+ */
+
+#include "Histograms.h"
+#include "TH2.h"
+
+using namespace std;
+
+static inline double axisValue(const HistAxis& axis, const SPSEvent& ev) {
+  switch (axis.source) {
+    case AXIS_CHANNEL: return ev.modules[axis.slot][axis.channel];
+    case AXIS_ALIAS: return ev.aliases[axis.index];
+    default: return ev.params[axis.index];
+  }
+}
+
+/*book()
+ *Creates empty histograms for the specs. They belong to no directory, so a thread can
+ *book and fill its own set while another thread has a file open.
+ */
+void HistogramSet::book(const vector<HistSpec>& histSpecs) {
+  specs = histSpecs;
+  hists.clear();
+  for (auto& spec : specs) {
+    const HistAxis& x = spec.axes[0];
+    string title = spec.name + ";" + x.name;
+    TH1* hist;
+    if (spec.axes.size() == 1) {
+      hist = new TH1D(spec.name.c_str(), (title + ";counts").c_str(), x.bins, x.low, x.high);
+    } else {
+      const HistAxis& y = spec.axes[1];
+      hist = new TH2D(spec.name.c_str(), (title + ";" + y.name).c_str(), x.bins, x.low, x.high,
+                      y.bins, y.low, y.high);
+    }
+    hist->SetDirectory(nullptr);
+    hists.emplace_back(hist);
+  }
+}
+
+/*fill()
+ *Adds one calibrated event to every histogram
+ */
+void HistogramSet::fill(const SPSEvent& ev) {
+  for (size_t i=0; i<hists.size(); i++) {
+    auto& axes = specs[i].axes;
+    double x = axisValue(axes[0], ev);
+    if (axes.size() == 1) hists[i]->Fill(x);
+    else static_cast<TH2*>(hists[i].get())->Fill(x, axisValue(axes[1], ev));
+  }
+}
+
+/*merge()
+ *Adds the counts of another thread's set, booked from the same specs
+ */
+void HistogramSet::merge(const HistogramSet& other) {
+  for (size_t i=0; i<hists.size() && i<other.hists.size(); i++) hists[i]->Add(other.hists[i].get());
+}
+
+/*write()
+ *Writes the histograms to the current directory, replacing earlier copies
+ */
+void HistogramSet::write() {
+  for (auto& hist : hists) hist->Write("", TObject::kOverwrite);
+}
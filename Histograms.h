@@ -0,0 +1,33 @@
+/*Histograms.h
+ *Histograms filled straight from the decoded events while converting (hist statements in
+ *the setup file), for SpecTcl-style quick looks without a second pass over the tree. Each
+ *thread that calibrates events fills its own HistogramSet, so filling needs no locks; the
+ *sets are merge()d once the threads are joined and written to the output file next to
+ *DataTree, or instead of it with --no-tree.
+ *
+ *Oct 2026
+ */
+
+#ifndef HISTOGRAMS_H
+#define HISTOGRAMS_H
+
+#include "TH1.h"
+#include <vector>
+#include <memory>
+#include "ChannelMap.h"
+#include "SPSEvent.h"
+
+class HistogramSet {
+  public:
+    void book(const std::vector<HistSpec>& histSpecs);
+    bool empty() const { return hists.empty(); };
+    void fill(const SPSEvent& ev);
+    void merge(const HistogramSet& other);
+    void write();
+
+  private:
+    std::vector<HistSpec> specs;
+    std::vector<std::unique_ptr<TH1>> hists; //TH1D or TH2D, by the number of axes
+};
+
+#endif
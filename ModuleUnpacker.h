@@ -0,0 +1,145 @@
+/*ModuleUnpacker.h
+ *Generic unpacker for VME modules whose readout is a header word, a run of data words
+ *and an end-of-event word, each 32 bits. Everything that differs from one module type to
+ *another (type bits, id/geo field, count field, channel and value fields) is supplied at
+ *compile time by a descriptor struct; see ADCUnpacker.h and mTDCUnpacker.h.
+ *
+ *The data sit in the physics item as 16-bit words, low half first, and a module block may
+ *start on any 16-bit boundary, so words are read as (possibly unaligned) 32-bit loads.
+ *
+ *Dispatch to the destination module is a table lookup: addModule() maps a geo/id to a
+ *slot, and parse() reports the slot (or -1 for an id that isn't in the stack).
+ *
+ *A data word of the wrong type is flagged UNPACK_BAD_DATUM and then handled as the old
+ *per-module unpackers did: the ADC stores 0 at channel 0 and keeps the rest of the block,
+ *the mTDC drops the block's data (Desc::BAD_DATUM_DROPS_BLOCK).
+ *
+ *Oct 2026
+ */
+
+#ifndef MODULEUNPACKER_H
+#define MODULEUNPACKER_H
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include "UnpackError.h"
+
+static const int MODULE_MAX_CHANNELS = 32;
+
+struct ParsedModuleEvent {
+  int s_id; //geo address for CAEN ADC/TDCs, module id for Mesytec
+  int s_slot; //destination slot from addModule(), -1 if unknown
+  int s_crate;
+  int s_res;
+  int s_count;
+  int s_eventNumber;
+  int s_errors; //OR of UnpackError flags
+  int s_nData;
+  std::pair<int, std::uint16_t> s_data[MODULE_MAX_CHANNELS];
+};
+
+template<class Desc>
+class ModuleUnpacker {
+  public:
+    static const int N_IDS = (Desc::ID_MASK >> Desc::ID_SHIFT) + 1;
+
+    ModuleUnpacker() {
+      for (int i=0; i<N_IDS; i++) slotOf[i] = -1;
+    };
+
+    void addModule(int id, int slot) {
+      if (id >= 0 && id < N_IDS) slotOf[id] = slot;
+    };
+
+    //takes the high (second) 16-bit half of a word, which holds the type bits
+    static bool isHeader(std::uint16_t highWord) {
+      return ((std::uint32_t(highWord) << 16) & Desc::TYPE_MASK) == Desc::TYPE_HDR;
+    };
+
+    const std::uint16_t* parse(const std::uint16_t* begin, const std::uint16_t* end,
+                               ParsedModuleEvent& event) const;
+
+  private:
+    static std::uint32_t read32(const std::uint16_t* word) {
+      std::uint32_t value;
+      std::memcpy(&value, word, 4);
+      return value;
+    };
+
+    std::int8_t slotOf[N_IDS];
+};
+
+/*parse()
+ *Decodes one block starting at begin (the low half of the header) into event, which
+ *is overwritten. Never allocates or throws; problems are OR'd into event.s_errors.
+ *Returns a pointer just past the end-of-event word.
+ */
+template<class Desc>
+const std::uint16_t* ModuleUnpacker<Desc>::parse(const std::uint16_t* begin,
+                                                 const std::uint16_t* end,
+                                                 ParsedModuleEvent& event) const {
+  event.s_errors = UNPACK_OK;
+  event.s_nData = 0;
+
+  auto iter = begin;
+  std::uint32_t header = read32(iter);
+  int nWords;
+  if ((header & Desc::TYPE_MASK) != Desc::TYPE_HDR) {
+    //not a valid header; skip straight to where the trailer should be
+    event.s_id = -1;
+    event.s_slot = -1;
+    event.s_crate = 0;
+    event.s_res = 0;
+    event.s_count = 0;
+    event.s_errors |= UNPACK_BAD_HEADER;
+    nWords = 0;
+  } else {
+    event.s_id = (header & Desc::ID_MASK) >> Desc::ID_SHIFT;
+    event.s_slot = slotOf[event.s_id];
+    event.s_crate = (header & Desc::CRATE_MASK) >> Desc::CRATE_SHIFT;
+    event.s_res = (header & Desc::RES_MASK) >> Desc::RES_SHIFT;
+    event.s_count = (header & Desc::COUNT_MASK) >> Desc::COUNT_SHIFT;
+    nWords = (event.s_count - Desc::COUNT_EXTRA)*2;
+  }
+  iter += 2;
+
+  auto dataEnd = iter + nWords;
+  if (dataEnd > end) {//don't read past the physics item
+    event.s_errors |= UNPACK_OVERRUN;
+    dataEnd = iter + ((end-iter)/2)*2;
+  }
+
+  if (event.s_slot < 0) {//If unexpected geo/id, skip data; either bad event or bad stack
+    if (!(event.s_errors & UNPACK_BAD_HEADER)) event.s_errors |= UNPACK_BAD_ID;
+    iter += nWords;
+  } else {
+    for (; iter < dataEnd; iter += 2) {
+      if (event.s_nData == MODULE_MAX_CHANNELS) {
+        event.s_errors |= UNPACK_OVERFLOW;
+        continue;
+      }
+      std::uint32_t word = read32(iter);
+      if ((word & Desc::TYPE_MASK) != Desc::TYPE_DATA) {//not valid data
+        event.s_errors |= UNPACK_BAD_DATUM;
+        if (!Desc::BAD_DATUM_DROPS_BLOCK) {//put 0 at chan 0
+          event.s_data[event.s_nData].first = 0;
+          event.s_data[event.s_nData++].second = 0;
+        }
+        continue;
+      }
+      auto& chanData = event.s_data[event.s_nData++];
+      chanData.first = (word & Desc::CHAN_MASK) >> Desc::CHAN_SHIFT;
+      chanData.second = word & Desc::DATA_MASK;
+    }
+    if (Desc::BAD_DATUM_DROPS_BLOCK && (event.s_errors & UNPACK_BAD_DATUM)) event.s_nData = 0;
+  }
+
+  if (iter+1 >= end || (read32(iter) & Desc::TYPE_MASK) != Desc::TYPE_TRAIL) {
+    event.s_errors |= UNPACK_NO_EOE;
+  }
+
+  return iter+2;
+}
+
+#endif
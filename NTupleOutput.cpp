@@ -0,0 +1,149 @@
+/*NTupleOutput.cpp
+ *RNTuple output; see NTupleOutput.h. The RNTuple classes left ROOT::Experimental in
+ *6.36, so the namespace is picked by version.
+ *
+ *Oct 2026
+ */
+
+#include "NTupleOutput.h"
+#include "TNamed.h"
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#ifdef EVT2ROOT_RNTUPLE
+#include <ROOT/RNTupleModel.hxx>
+#include <ROOT/RNTupleWriter.hxx>
+#include <ROOT/RNTupleWriteOptions.hxx>
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,36,0)
+namespace RNT = ROOT;
+#else
+namespace RNT = ROOT::Experimental;
+#endif
+#endif
+
+using namespace std;
+
+typedef array<Int_t, 32> ModuleArray;
+
+struct NTupleOutput::Fields {
+#ifdef EVT2ROOT_RNTUPLE
+  unique_ptr<RNT::RNTupleWriter> writer;
+  //values of the writer's default entry; aliases and params in SPSEvent index order
+  vector<shared_ptr<ModuleArray>> modules;
+  shared_ptr<vector<UChar_t>> hitModule, hitChannel;
+  shared_ptr<vector<Int_t>> hitValue;
+  shared_ptr<UInt_t> run;
+  shared_ptr<ULong64_t> event;
+  vector<shared_ptr<Int_t>> aliases;
+  vector<shared_ptr<Float_t>> params;
+#endif
+  bool sparse = false;
+  int nModules = 0;
+};
+
+NTupleOutput::NTupleOutput() : fields(new Fields) {}
+
+NTupleOutput::~NTupleOutput() {
+  close();
+}
+
+bool NTupleOutput::available() {
+#ifdef EVT2ROOT_RNTUPLE
+  return true;
+#else
+  return false;
+#endif
+}
+
+/*open()
+ *Builds the model for the setup and starts writing DataTree into file, which must stay
+ *open until close(). For the sparse layout the module names by hit_module index are
+ *written next to it as a TNamed "hit_modules", the same string the tree keeps in its
+ *user info.
+ */
+bool NTupleOutput::open(TFile& file, const ChannelMap& setup, bool sparse,
+                        const OutputSettings& output, string& error) {
+#ifdef EVT2ROOT_RNTUPLE
+  Fields& f = *fields;
+  f.sparse = sparse;
+  f.nModules = setup.getModules().size();
+  auto model = RNT::RNTupleModel::Create();
+  if (sparse) {
+    f.hitModule = model->MakeField<vector<UChar_t>>("hit_module");
+    f.hitChannel = model->MakeField<vector<UChar_t>>("hit_channel");
+    f.hitValue = model->MakeField<vector<Int_t>>("hit_value");
+  } else {
+    for (auto& module : setup.getModules()) f.modules.push_back(model->MakeField<ModuleArray>(module.name));
+  }
+  f.run = model->MakeField<UInt_t>("run");
+  f.event = model->MakeField<ULong64_t>("event");
+  for (auto& branch : setup.getBranches()) {
+    if (branch.alias) f.aliases.push_back(model->MakeField<Int_t>(branch.name));
+    else f.params.push_back(model->MakeField<Float_t>(branch.name));
+  }
+  RNT::RNTupleWriteOptions options;
+  options.SetCompression(output.compression());
+  try {
+    f.writer = RNT::RNTupleWriter::Append(std::move(model), "DataTree", file, options);
+  } catch (const exception& e) {
+    error = string("Unable to write RNTuple: ") + e.what();
+    return false;
+  }
+  if (sparse) {
+    string names;
+    for (auto& module : setup.getModules()) names += (names.empty() ? "" : " ") + module.name;
+    TNamed info("hit_modules", names.c_str());
+    file.WriteTObject(&info);
+  }
+  return true;
+#else
+  (void) file; (void) setup; (void) sparse; (void) output;
+  error = "RNTuple output needs ROOT 6.34 or later";
+  return false;
+#endif
+}
+
+/*fill()
+ *Appends one event; the same values DataTree would get
+ */
+void NTupleOutput::fill(const SPSEvent& ev) {
+#ifdef EVT2ROOT_RNTUPLE
+  Fields& f = *fields;
+  if (f.sparse) {
+    f.hitModule->clear();
+    f.hitChannel->clear();
+    f.hitValue->clear();
+    for (int slot=0; slot<f.nModules; slot++) {
+      UInt_t fired = ev.fired[slot];
+      while (fired) {
+        int chan = __builtin_ctz(fired);
+        fired &= fired-1;
+        f.hitModule->push_back(slot);
+        f.hitChannel->push_back(chan);
+        f.hitValue->push_back(ev.modules[slot][chan]);
+      }
+    }
+  } else {
+    for (int slot=0; slot<f.nModules; slot++) {
+      memcpy(f.modules[slot]->data(), ev.modules[slot], sizeof(ev.modules[slot]));
+    }
+  }
+  *f.run = ev.run;
+  *f.event = ev.event;
+  for (size_t k=0; k<f.aliases.size(); k++) *f.aliases[k] = ev.aliases[k];
+  for (size_t k=0; k<f.params.size(); k++) *f.params[k] = ev.params[k];
+  f.writer->Fill();
+#else
+  (void) ev;
+#endif
+}
+
+/*close()
+ *Commits the last cluster and the footer; the file can be closed afterwards
+ */
+void NTupleOutput::close() {
+#ifdef EVT2ROOT_RNTUPLE
+  fields->writer.reset();
+#endif
+}
@@ -0,0 +1,45 @@
+/*NTupleOutput.h
+ *RNTuple version of DataTree (--format rntuple): the same fields as the tree, written
+ *column-wise with RNTupleWriter. Each module is a fixed std::array<Int_t, 32> field, so
+ *the dense layout needs no per-entry offsets; the sparse layout keeps the three hit
+ *lists as vectors, with the module names by hit_module index in a TNamed "hit_modules". Run, event, aliases and parameters are plain scalar fields, in the
+ *order the setup declares them. The RNTuple is named DataTree, so RDataFrame("DataTree",
+ *file) reads either format.
+ *
+ *Needs ROOT 6.34 or later, where the RNTuple on-disk format is final; with older ROOT
+ *available() is false and the converter refuses the option.
+ *
+ *Oct 2026
+ */
+
+#ifndef NTUPLEOUTPUT_H
+#define NTUPLEOUTPUT_H
+
+#include <memory>
+#include <string>
+#include "TFile.h"
+#include "RVersion.h"
+#include "ChannelMap.h"
+#include "SPSEvent.h"
+#include "OutputSettings.h"
+
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,34,0)
+#define EVT2ROOT_RNTUPLE 1
+#endif
+
+class NTupleOutput {
+  public:
+    NTupleOutput();
+    ~NTupleOutput();
+    static bool available();
+    bool open(TFile& file, const ChannelMap& setup, bool sparse, const OutputSettings& output,
+              std::string& error);
+    void fill(const SPSEvent& ev);
+    void close();
+
+  private:
+    struct Fields; //RNTuple types stay out of the header
+    std::unique_ptr<Fields> fields;
+};
+
+#endif
@@ -0,0 +1,79 @@
+/*OutputSettings.h
+ *Tuning knobs for the ROOT output: compression algorithm and level, branch basket size,
+ *AutoFlush (cluster size) and AutoSave interval. Named profiles bundle them for common uses;
+ *individual command line options override the profile.
+ *
+ *  quicklook  LZ4 level 4:  fastest writes, largest files
+ *  default    ZSTD level 5: the shipped profile
+ *  archival   LZMA level 8: smallest files, slowest writes
+ *
+ *The profiles can be re-measured on real data with ./evt2root --benchmark-profiles.
+ *
+ *Oct 2026
+ */
+
+#ifndef OUTPUTSETTINGS_H
+#define OUTPUTSETTINGS_H
+
+#include <string>
+#include "Rtypes.h"
+
+//same values as ROOT::RCompressionSetting::EAlgorithm
+enum CompressionAlgorithm {
+  COMPRESS_ZLIB = 1,
+  COMPRESS_LZMA = 2,
+  COMPRESS_LZ4 = 4,
+  COMPRESS_ZSTD = 5
+};
+
+struct OutputSettings {
+  std::string profile = "default";
+  int algorithm = COMPRESS_ZSTD;
+  int level = 5;
+  Int_t basketSize = 256000; //bytes per branch buffer
+  Long64_t autoFlush = -30000000; //cluster size: >0 entries, <0 bytes, 0 off (TTree::SetAutoFlush)
+  //tree header saved to the file every so often, so a crash loses at most this much:
+  //>0 entries, <0 bytes, 0 never (TTree::SetAutoSave). Not part of the profiles.
+  Long64_t autoSave = 1000000;
+
+  //ROOT's combined algorithm*100+level form, as taken by TFile
+  int compression() const { return algorithm*100 + level; };
+
+  /*setProfile()
+   *Loads the named profile; returns false (leaving settings alone) if it is unknown.
+   */
+  bool setProfile(const std::string& name) {
+    if (name == "quicklook") {
+      algorithm = COMPRESS_LZ4;
+      level = 4;
+      basketSize = 256000;
+      autoFlush = -30000000;
+    } else if (name == "default") {
+      algorithm = COMPRESS_ZSTD;
+      level = 5;
+      basketSize = 256000;
+      autoFlush = -30000000;
+    } else if (name == "archival") {
+      algorithm = COMPRESS_LZMA;
+      level = 8;
+      basketSize = 512000;
+      autoFlush = -100000000;
+    } else return false;
+    profile = name;
+    return true;
+  };
+
+  /*setAlgorithm()
+   *Takes zlib, lzma, lz4 or zstd; returns false if the name is unknown.
+   */
+  bool setAlgorithm(const std::string& name) {
+    if (name == "zlib") algorithm = COMPRESS_ZLIB;
+    else if (name == "lzma") algorithm = COMPRESS_LZMA;
+    else if (name == "lz4") algorithm = COMPRESS_LZ4;
+    else if (name == "zstd") algorithm = COMPRESS_ZSTD;
+    else return false;
+    return true;
+  };
+};
+
+#endif
@@ -0,0 +1,522 @@
+/*ParamProgram.cpp
+ *Expression compiler and evaluation kernels for the derived parameters; see ParamProgram.h.
+ *As in Calibration.cpp the AVX2 kernel is compiled with a target attribute, picked at run
+ *time, and uses only the operations of the scalar code, so results match bit for bit.
+ *
+ *Oct 2026
+ */
+
+#include "ParamProgram.h"
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PARAMPROGRAM_X86 1
+#endif
+
+using namespace std;
+
+enum ParamOpCode : uint8_t {
+  OP_ADD,
+  OP_SUB,
+  OP_MUL,
+  OP_DIV,
+  OP_MIN,
+  OP_MAX,
+  OP_LT, //comparisons and logic give 1 or 0
+  OP_LE,
+  OP_GT,
+  OP_GE,
+  OP_EQ,
+  OP_NE,
+  OP_AND,
+  OP_OR,
+  OP_NEG, //unary from here on; b is unused
+  OP_ABS,
+  OP_SQRT,
+  OP_NOT
+};
+
+static inline float apply(uint8_t code, float a, float b) {
+  switch (code) {
+    case OP_ADD: return a+b;
+    case OP_SUB: return a-b;
+    case OP_MUL: return a*b;
+    case OP_DIV: return a/b;
+    case OP_MIN: return a < b ? a : b; //same operand order as _mm256_min_ps
+    case OP_MAX: return a > b ? a : b;
+    //NaN compares false except for !=, and counts as true, as in the AVX2 predicates
+    case OP_LT: return a < b;
+    case OP_LE: return a <= b;
+    case OP_GT: return a > b;
+    case OP_GE: return a >= b;
+    case OP_EQ: return a == b;
+    case OP_NE: return a != b;
+    case OP_AND: return a != 0 && b != 0;
+    case OP_OR: return a != 0 || b != 0;
+    case OP_NEG: return -a;
+    case OP_ABS: return fabsf(a);
+    case OP_SQRT: return sqrtf(a);
+    default: return a == 0;
+  }
+}
+
+/*Parser
+ *Recursive descent over one expression, emitting operations into the program as it goes
+ */
+class ParamProgram::Parser {
+  public:
+    Parser(ParamProgram& p, const string& t, string& e) : program(p), text(t), error(e) {};
+
+    bool parse(Value& value) {
+      if (!expression(value)) return false;
+      skip();
+      if (pos != text.size()) return fail("unexpected '" + text.substr(pos, 1) + "'");
+      return true;
+    };
+
+  private:
+    void skip() {
+      while (pos < text.size() && isspace((unsigned char) text[pos])) pos++;
+    };
+    bool accept(char c) {
+      skip();
+      if (pos < text.size() && text[pos] == c) {
+        pos++;
+        return true;
+      }
+      return false;
+    };
+    bool expect(char c) {
+      if (accept(c)) return true;
+      return fail(string("expected '") + c + "'");
+    };
+    bool fail(const string& message) {
+      if (error.empty()) error = message;
+      return false;
+    };
+    //a two character operator, or c alone when not followed by next
+    bool accept(char c, char next) {
+      skip();
+      if (pos+1 < text.size() && text[pos] == c && text[pos+1] == next) {
+        pos += 2;
+        return true;
+      }
+      return false;
+    };
+    bool acceptAlone(char c, char notNext) {
+      skip();
+      if (pos < text.size() && text[pos] == c && (pos+1 == text.size() || text[pos+1] != notNext)) {
+        pos++;
+        return true;
+      }
+      return false;
+    };
+
+    bool expression(Value& value) {
+      if (!conjunction(value)) return false;
+      while (accept('|', '|')) {
+        Value rhs;
+        if (!conjunction(rhs) || !program.emit(OP_OR, value, rhs, value, error)) return false;
+      }
+      return true;
+    };
+
+    bool conjunction(Value& value) {
+      if (!comparison(value)) return false;
+      while (accept('&', '&')) {
+        Value rhs;
+        if (!comparison(rhs) || !program.emit(OP_AND, value, rhs, value, error)) return false;
+      }
+      return true;
+    };
+
+    bool comparison(Value& value) {
+      if (!sum(value)) return false;
+      uint8_t code;
+      if (accept('<', '=')) code = OP_LE;
+      else if (accept('>', '=')) code = OP_GE;
+      else if (accept('=', '=')) code = OP_EQ;
+      else if (accept('!', '=')) code = OP_NE;
+      else if (accept('<')) code = OP_LT;
+      else if (accept('>')) code = OP_GT;
+      else return true;
+      Value rhs;
+      return sum(rhs) && program.emit(code, value, rhs, value, error);
+    };
+
+    bool sum(Value& value) {
+      if (!product(value)) return false;
+      while (true) {
+        uint8_t code;
+        if (accept('+')) code = OP_ADD;
+        else if (accept('-')) code = OP_SUB;
+        else return true;
+        Value rhs;
+        if (!product(rhs) || !program.emit(code, value, rhs, value, error)) return false;
+      }
+    };
+
+    bool product(Value& value) {
+      if (!unary(value)) return false;
+      while (true) {
+        uint8_t code;
+        if (accept('*')) code = OP_MUL;
+        else if (accept('/')) code = OP_DIV;
+        else return true;
+        Value rhs;
+        if (!unary(rhs) || !program.emit(code, value, rhs, value, error)) return false;
+      }
+    };
+
+    bool unary(Value& value) {
+      uint8_t code;
+      if (accept('-')) code = OP_NEG;
+      else if (acceptAlone('!', '=')) code = OP_NOT;
+      else return primary(value);
+      Value operand;
+      return unary(operand) && program.emit(code, operand, operand, value, error);
+    };
+
+    bool primary(Value& value) {
+      if (accept('(')) return expression(value) && expect(')');
+      skip();
+      if (pos == text.size()) return fail("expression ends early");
+      const char* start = text.c_str()+pos;
+      if (isdigit((unsigned char) *start) || *start == '.') {
+        char* end;
+        float number = strtof(start, &end);
+        if (end == start) return fail("bad number");
+        pos += end-start;
+        return program.constant(number, value, error);
+      }
+      if (!isalpha((unsigned char) *start) && *start != '_') {
+        return fail("expected a number, name or '('");
+      }
+      size_t first = pos;
+      while (pos < text.size() && (isalnum((unsigned char) text[pos]) || text[pos] == '_')) pos++;
+      string name = text.substr(first, pos-first);
+
+      if (name == "fired" && accept('(')) return fired(value);
+      if (accept('(')) return function(name, value);
+      if (accept('[')) {
+        int slot, channel;
+        return channelOf(name, slot, channel) && program.input(slot, channel, false, value, error);
+      }
+      auto known = program.names.find(name);
+      if (known != program.names.end()) {
+        value = known->second;
+        return true;
+      }
+      if (program.modules.count(name)) {
+        return fail("module '" + name + "' needs a channel, e.g. " + name + "[0]");
+      }
+      return fail("unknown name '" + name + "'");
+    };
+
+    //the rest of MODULE[CHANNEL], after the '['
+    bool channelOf(const string& name, int& slot, int& channel) {
+      auto module = program.modules.find(name);
+      if (module == program.modules.end()) return fail("unknown module '" + name + "'");
+      skip();
+      size_t digits = pos;
+      while (pos < text.size() && isdigit((unsigned char) text[pos])) pos++;
+      if (pos == digits) return fail("expected a channel number");
+      slot = module->second;
+      channel = atoi(text.c_str()+digits);
+      return expect(']');
+    };
+
+    //fired(MODULE[CHANNEL]) or fired(ALIAS): 1 if the channel was read out, else 0
+    bool fired(Value& value) {
+      skip();
+      size_t first = pos;
+      while (pos < text.size() && (isalnum((unsigned char) text[pos]) || text[pos] == '_')) pos++;
+      string name = text.substr(first, pos-first);
+      int slot, channel;
+      if (accept('[')) {
+        if (!channelOf(name, slot, channel)) return false;
+      } else {
+        auto alias = program.aliases.find(name);
+        if (alias == program.aliases.end()) return fail("fired() takes MODULE[CHANNEL] or an alias");
+        slot = alias->second.slot;
+        channel = alias->second.channel;
+      }
+      return expect(')') && program.input(slot, channel, true, value, error);
+    };
+
+    bool function(const string& name, Value& value) {
+      vector<Value> args(1);
+      if (!expression(args[0])) return false;
+      while (accept(',')) {
+        args.emplace_back();
+        if (!expression(args.back())) return false;
+      }
+      if (!expect(')')) return false;
+      size_t wanted = name == "min" || name == "max" ? 2 : 1;
+      if (name != "dither" && name != "abs" && name != "sqrt" && wanted == 1) {
+        return fail("unknown function '" + name + "'");
+      }
+      if (args.size() != wanted) return fail(name + "() takes " + to_string(wanted) + " argument(s)");
+
+      if (name == "dither") {
+        if (program.drawColumns.size() == (size_t) MAX_DRAWS) {
+          return fail("more than " + to_string(MAX_DRAWS) + " dither() calls");
+        }
+        Value draw = {0, false, 0};
+        if (!program.newColumn(draw.column, error)) return false;
+        program.drawColumns.push_back(draw.column);
+        return program.emit(OP_ADD, args[0], draw, value, error);
+      }
+      uint8_t code = name == "min" ? OP_MIN : name == "max" ? OP_MAX :
+                     name == "abs" ? OP_ABS : OP_SQRT;
+      return program.emit(code, args[0], args.back(), value, error);
+    };
+
+    ParamProgram& program;
+    const string& text;
+    string& error;
+    size_t pos = 0;
+};
+
+bool ParamProgram::newColumn(size_t& column, string& error) {
+  if (nColumns == MAX_COLUMNS) {
+    error = "setup needs more than " + to_string(MAX_COLUMNS) + " columns";
+    return false;
+  }
+  column = nColumns++;
+  return true;
+}
+
+/*input()
+ *Column holding a module channel, or whether it fired; each gets one column however often
+ *it is used
+ */
+bool ParamProgram::input(int slot, int channel, bool fired, Value& value, string& error) {
+  if (channel < 0 || channel >= 32) {
+    error = "channel " + to_string(channel) + " is out of range (0-31)";
+    return false;
+  }
+  value = {0, false, 0};
+  for (size_t k=0; k<inputs.size(); k++) {
+    if (inputs[k].slot == slot && inputs[k].channel == channel && inputs[k].fired == fired) {
+      value.column = inputColumns[k];
+      return true;
+    }
+  }
+  if (!newColumn(value.column, error)) return false;
+  inputs.push_back({slot, channel, fired});
+  inputColumns.push_back(value.column);
+  return true;
+}
+
+bool ParamProgram::constant(float number, Value& value, string& error) {
+  value = {0, true, number};
+  for (auto& c : constants) {
+    if (c.second == number && signbit(c.second) == signbit(number)) {
+      value.column = c.first;
+      return true;
+    }
+  }
+  if (!newColumn(value.column, error)) return false;
+  constants.push_back(make_pair(value.column, number));
+  return true;
+}
+
+/*emit()
+ *Appends one operation, or works it out now if its operands are constant
+ */
+bool ParamProgram::emit(uint8_t code, const Value& a, const Value& b, Value& result,
+                        string& error) {
+  if (a.constant && (b.constant || code >= OP_NEG)) {
+    return constant(apply(code, a.number, b.number), result, error);
+  }
+  Value out = {0, false, 0};
+  if (!newColumn(out.column, error)) return false;
+  ops.push_back({code, (uint16_t) out.column, (uint16_t) a.column, (uint16_t) b.column});
+  result = out;
+  return true;
+}
+
+bool ParamProgram::compile(const string& expression, Value& value, string& error) {
+  error.clear();
+  Parser parser(*this, expression, error);
+  return parser.parse(value);
+}
+
+bool ParamProgram::isDefined(const string& name) const {
+  return names.count(name) || modules.count(name);
+}
+
+/*addAlias()
+ *Names a module channel for use in expressions
+ */
+bool ParamProgram::addAlias(const string& name, int slot, int channel, string& error) {
+  Value value;
+  if (!input(slot, channel, false, value, error)) return false;
+  names[name] = value;
+  aliases[name] = {slot, channel, false};
+  return true;
+}
+
+bool ParamProgram::addConstant(const string& name, const string& expression, string& error) {
+  Value value;
+  if (!compile(expression, value, error)) return false;
+  if (!value.constant) {
+    error = "constant '" + name + "' depends on the event";
+    return false;
+  }
+  names[name] = value;
+  return true;
+}
+
+/*addParameter()
+ *Compiles a derived parameter. Outputs are numbered in the order they are added.
+ */
+bool ParamProgram::addParameter(const string& name, const string& expression, bool output,
+                                string& error) {
+  Value value;
+  if (!compile(expression, value, error)) return false;
+  names[name] = value;
+  if (output) outputColumns.push_back(value.column);
+  return true;
+}
+
+/*addGate()
+ *Compiles a gate: events for which it is 0 are rejected. Gates are numbered in the order
+ *they are added.
+ */
+bool ParamProgram::addGate(const string& name, const string& expression, string& error) {
+  Value value;
+  if (!compile(expression, value, error)) return false;
+  names[name] = value;
+  gateColumns.push_back(value.column);
+  return true;
+}
+
+/*prepare()
+ *Sizes a batch for this program and fills in its constant columns, which evaluate()
+ *never overwrites
+ */
+void ParamProgram::prepare(ParamBatch& batch) const {
+  batch.columns.assign(nColumns*CALIB_BATCH, 0.0f);
+  for (auto& c : constants) {
+    float* column = batch.column(c.first);
+    for (size_t i=0; i<CALIB_BATCH; i++) column[i] = c.second;
+  }
+}
+
+/*evaluateOne()
+ *The program for a single event whose input and draw values have been stored at their
+ *column numbers in values (getColumns() entries)
+ */
+void ParamProgram::evaluateOne(float* values) const {
+  for (auto& c : constants) values[c.first] = c.second;
+  for (auto& op : ops) values[op.dst] = apply(op.code, values[op.a], values[op.b]);
+}
+
+template<uint8_t CODE>
+static inline void columnOp(float* d, const float* a, const float* b, size_t n) {
+  for (size_t i=0; i<n; i++) d[i] = apply(CODE, a[i], b[i]);
+}
+
+static void evaluateScalar(const vector<ParamOp>& ops, float* columns, size_t n) {
+  for (auto& op : ops) {
+    float* d = columns + op.dst*CALIB_BATCH;
+    const float* a = columns + op.a*CALIB_BATCH;
+    const float* b = columns + op.b*CALIB_BATCH;
+    switch (op.code) {
+      case OP_ADD: columnOp<OP_ADD>(d, a, b, n); break;
+      case OP_SUB: columnOp<OP_SUB>(d, a, b, n); break;
+      case OP_MUL: columnOp<OP_MUL>(d, a, b, n); break;
+      case OP_DIV: columnOp<OP_DIV>(d, a, b, n); break;
+      case OP_MIN: columnOp<OP_MIN>(d, a, b, n); break;
+      case OP_MAX: columnOp<OP_MAX>(d, a, b, n); break;
+      case OP_LT: columnOp<OP_LT>(d, a, b, n); break;
+      case OP_LE: columnOp<OP_LE>(d, a, b, n); break;
+      case OP_GT: columnOp<OP_GT>(d, a, b, n); break;
+      case OP_GE: columnOp<OP_GE>(d, a, b, n); break;
+      case OP_EQ: columnOp<OP_EQ>(d, a, b, n); break;
+      case OP_NE: columnOp<OP_NE>(d, a, b, n); break;
+      case OP_AND: columnOp<OP_AND>(d, a, b, n); break;
+      case OP_OR: columnOp<OP_OR>(d, a, b, n); break;
+      case OP_NEG: columnOp<OP_NEG>(d, a, b, n); break;
+      case OP_ABS: columnOp<OP_ABS>(d, a, b, n); break;
+      case OP_SQRT: columnOp<OP_SQRT>(d, a, b, n); break;
+      case OP_NOT: columnOp<OP_NOT>(d, a, b, n); break;
+    }
+  }
+}
+
+#ifdef PARAMPROGRAM_X86
+//columns are CALIB_BATCH (a multiple of 8) long, so the last group of 8 can run past n
+__attribute__((target("avx2")))
+static void evaluateAVX2(const vector<ParamOp>& ops, float* columns, size_t n) {
+  const __m256 sign = _mm256_set1_ps(-0.0f);
+  const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+  size_t lanes = (n+7) & ~(size_t) 7;
+  for (auto& op : ops) {
+    float* d = columns + op.dst*CALIB_BATCH;
+    const float* a = columns + op.a*CALIB_BATCH;
+    const float* b = columns + op.b*CALIB_BATCH;
+    //the operation is chosen once per column, not once per group of 8
+#define PARAM_LANES(expression) \
+    for (size_t i=0; i<lanes; i+=8) { \
+      __m256 x = _mm256_loadu_ps(a+i), y = _mm256_loadu_ps(b+i); \
+      (void) y; \
+      _mm256_storeu_ps(d+i, expression); \
+    } \
+    break;
+    switch (op.code) {
+      case OP_ADD: PARAM_LANES(_mm256_add_ps(x, y))
+      case OP_SUB: PARAM_LANES(_mm256_sub_ps(x, y))
+      case OP_MUL: PARAM_LANES(_mm256_mul_ps(x, y))
+      case OP_DIV: PARAM_LANES(_mm256_div_ps(x, y))
+      case OP_MIN: PARAM_LANES(_mm256_min_ps(x, y))
+      case OP_MAX: PARAM_LANES(_mm256_max_ps(x, y))
+      //comparison masks are all ones or zero; and-ing with 1.0f gives 1 or 0
+      case OP_LT: PARAM_LANES(_mm256_and_ps(_mm256_cmp_ps(x, y, _CMP_LT_OQ), one))
+      case OP_LE: PARAM_LANES(_mm256_and_ps(_mm256_cmp_ps(x, y, _CMP_LE_OQ), one))
+      case OP_GT: PARAM_LANES(_mm256_and_ps(_mm256_cmp_ps(x, y, _CMP_GT_OQ), one))
+      case OP_GE: PARAM_LANES(_mm256_and_ps(_mm256_cmp_ps(x, y, _CMP_GE_OQ), one))
+      case OP_EQ: PARAM_LANES(_mm256_and_ps(_mm256_cmp_ps(x, y, _CMP_EQ_OQ), one))
+      case OP_NE: PARAM_LANES(_mm256_and_ps(_mm256_cmp_ps(x, y, _CMP_NEQ_UQ), one))
+      case OP_AND: PARAM_LANES(_mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(x, zero, _CMP_NEQ_UQ),
+                                                           _mm256_cmp_ps(y, zero, _CMP_NEQ_UQ)), one))
+      case OP_OR: PARAM_LANES(_mm256_and_ps(_mm256_or_ps(_mm256_cmp_ps(x, zero, _CMP_NEQ_UQ),
+                                                         _mm256_cmp_ps(y, zero, _CMP_NEQ_UQ)), one))
+      case OP_NEG: PARAM_LANES(_mm256_xor_ps(x, sign))
+      case OP_ABS: PARAM_LANES(_mm256_andnot_ps(sign, x))
+      case OP_SQRT: PARAM_LANES(_mm256_sqrt_ps(x))
+      case OP_NOT: PARAM_LANES(_mm256_and_ps(_mm256_cmp_ps(x, zero, _CMP_EQ_OQ), one))
+    }
+#undef PARAM_LANES
+  }
+}
+#endif
+
+struct ParamKernel {
+  const char* name;
+  void (*evaluate)(const vector<ParamOp>&, float*, size_t);
+};
+
+static ParamKernel pickKernel() {
+#ifdef PARAMPROGRAM_X86
+  if (__builtin_cpu_supports("avx2")) return {"avx2", evaluateAVX2};
+#endif
+  return {"scalar", evaluateScalar};
+}
+
+static const ParamKernel kernel = pickKernel();
+
+/*evaluate()
+ *Runs the program over events [0, batch.n) of a prepared batch
+ */
+void ParamProgram::evaluate(ParamBatch& batch) const {
+  kernel.evaluate(ops, batch.columns.data(), batch.n);
+}
+
+const char* paramProgramImpl() {
+  return kernel.name;
+}
@@ -0,0 +1,110 @@
+/*ParamProgram.h
+ *Derived parameters compiled from expressions such as
+ *  (dither(mtdc1[2]) - dither(mtdc1[1]))*nanos_per_chan/2
+ *Each expression is parsed once, at startup, into a flat list of three-address operations
+ *on columns of floats. A batch is evaluated one operation at a time over all of its events,
+ *so there is no parsing, name lookup or branching per event, and the AVX2 version works on
+ *8 events per instruction as the rebin kernel in Calibration.cpp does. The per-event path runs the
+ *same operations on one event, so both give identical results.
+ *
+ *Columns hold the channels read (converted to float), the random draws, the constants and
+ *the result of each operation. The caller fills the channel and draw columns of each event
+ *(inputColumn(), drawColumn()) and reads the results back from outputColumn().
+ *
+ *Expressions: numbers, + - * / and unary minus, parentheses, MODULE[CHANNEL], aliases,
+ *constants and earlier parameters, and the functions dither(x), abs(x), sqrt(x), min(x, y)
+ *and max(x, y). dither(x) is x plus the event's next uniform [0,1) draw; draws are handed
+ *out in the order they appear, at most MAX_DRAWS per event. For gates there are also the
+ *comparisons < <= > >= == !=, && || and !, which give 1 or 0 (anything non-zero is true),
+ *and fired(MODULE[CHANNEL]) or fired(ALIAS), 1 if the channel was read out.
+ *
+ *Plain types only, so the benchmark can be built without ROOT.
+ *
+ *Oct 2026
+ */
+
+#ifndef PARAMPROGRAM_H
+#define PARAMPROGRAM_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+#include <cstddef>
+#include "Calibration.h"
+
+//one module channel read by the program: its value, or 1/0 for whether it fired
+struct ParamInput {
+  int slot;
+  int channel;
+  bool fired;
+};
+
+struct ParamOp {
+  std::uint8_t code;
+  std::uint16_t dst, a, b;
+};
+
+//column storage for one batch of up to CALIB_BATCH events; see ParamProgram::prepare()
+struct ParamBatch {
+  std::size_t n = 0;
+  std::vector<float> columns;
+  float* column(std::size_t k) { return columns.data() + k*CALIB_BATCH; };
+};
+
+class ParamProgram {
+  public:
+    static const int MAX_DRAWS = 32; //one philoxUniform32() block per event
+    static const std::size_t MAX_COLUMNS = 1024;
+
+    void addModule(const std::string& name, int slot) { modules[name] = slot; };
+    bool addAlias(const std::string& name, int slot, int channel, std::string& error);
+    bool addConstant(const std::string& name, const std::string& expression, std::string& error);
+    bool addParameter(const std::string& name, const std::string& expression, bool output,
+                      std::string& error);
+    bool addGate(const std::string& name, const std::string& expression, std::string& error);
+    bool isDefined(const std::string& name) const;
+
+    const std::vector<ParamInput>& getInputs() const { return inputs; };
+    std::size_t inputColumn(std::size_t k) const { return inputColumns[k]; };
+    int getDraws() const { return drawColumns.size(); };
+    std::size_t drawColumn(int k) const { return drawColumns[k]; };
+    std::size_t getOutputs() const { return outputColumns.size(); };
+    std::size_t outputColumn(std::size_t k) const { return outputColumns[k]; };
+    std::size_t getGates() const { return gateColumns.size(); };
+    std::size_t gateColumn(std::size_t k) const { return gateColumns[k]; };
+    std::size_t getColumns() const { return nColumns; };
+    std::size_t getOps() const { return ops.size(); };
+
+    void prepare(ParamBatch& batch) const;
+    void evaluate(ParamBatch& batch) const;
+    void evaluateOne(float* values) const;
+
+  private:
+    //a compiled (sub)expression: the column holding it, and its value if it is constant
+    struct Value {
+      std::size_t column;
+      bool constant;
+      float number;
+    };
+    class Parser;
+
+    bool newColumn(std::size_t& column, std::string& error);
+    bool input(int slot, int channel, bool fired, Value& value, std::string& error);
+    bool constant(float number, Value& value, std::string& error);
+    bool emit(std::uint8_t code, const Value& a, const Value& b, Value& result, std::string& error);
+    bool compile(const std::string& expression, Value& value, std::string& error);
+
+    std::map<std::string, int> modules;
+    std::map<std::string, Value> names; //aliases, constants, parameters and gates
+    std::map<std::string, ParamInput> aliases;
+    std::vector<ParamInput> inputs;
+    std::vector<std::size_t> inputColumns, drawColumns, outputColumns, gateColumns;
+    std::vector<std::pair<std::size_t, float>> constants;
+    std::vector<ParamOp> ops;
+    std::size_t nColumns = 0;
+};
+
+const char* paramProgramImpl(); //name of the kernel evaluate() uses
+
+#endif
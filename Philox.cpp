@@ -0,0 +1,90 @@
+/*Philox.cpp
+ *Scalar and AVX2 kernels for philoxUniform32(). The AVX2 kernel runs the eight
+ *Philox blocks of a stream in the eight 32-bit lanes of a register and is picked at run
+ *time, as in WordScan.cpp.
+ *
+ *Oct 2026
+ */
+
+#include "Philox.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PHILOX_X86 1
+#endif
+
+using namespace std;
+
+//key: the run number and a fixed salt; counter: (block, stream, event low, event high)
+static const uint32_t PHILOX_SALT = 0x53505331; //"SPS1"
+
+void philoxUniform32Scalar(uint32_t run, uint64_t event, uint32_t stream, float out[32]) {
+  for (uint32_t block=0; block<8; block++) {
+    uint32_t ctr[4] = {block, stream, (uint32_t)event, (uint32_t)(event >> 32)};
+    philoxBlock(ctr, run, PHILOX_SALT);
+    for (int word=0; word<4; word++) out[word*8+block] = philoxToFloat(ctr[word]);
+  }
+}
+
+#ifdef PHILOX_X86
+//32x32->64 multiply of all eight lanes, split into high and low halves
+__attribute__((target("avx2")))
+static inline void mulhilo8(__m256i a, __m256i m, __m256i& hi, __m256i& lo) {
+  __m256i even = _mm256_mul_epu32(a, m);
+  __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), m);
+  lo = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xaa);
+  hi = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xaa);
+}
+
+__attribute__((target("avx2")))
+static void philoxUniform32AVX2(uint32_t run, uint64_t event, uint32_t stream, float out[32]) {
+  const __m256i M0 = _mm256_set1_epi32((int)0xD2511F53);
+  const __m256i M1 = _mm256_set1_epi32((int)0xCD9E8D57);
+  __m256i c0 = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  __m256i c1 = _mm256_set1_epi32((int)stream);
+  __m256i c2 = _mm256_set1_epi32((int)(uint32_t)event);
+  __m256i c3 = _mm256_set1_epi32((int)(uint32_t)(event >> 32));
+  uint32_t k0 = run, k1 = PHILOX_SALT;
+  for (int round=0; round<10; round++) {
+    __m256i hi0, lo0, hi1, lo1;
+    mulhilo8(c0, M0, hi0, lo0);
+    mulhilo8(c2, M1, hi1, lo1);
+    c0 = _mm256_xor_si256(_mm256_xor_si256(hi1, c1), _mm256_set1_epi32((int)k0));
+    c1 = lo1;
+    c2 = _mm256_xor_si256(_mm256_xor_si256(hi0, c3), _mm256_set1_epi32((int)k1));
+    c3 = lo0;
+    k0 += 0x9E3779B9;
+    k1 += 0xBB67AE85;
+  }
+  const __m256 scale = _mm256_set1_ps(1.0f/8388608.0f);
+  const __m256 half = _mm256_set1_ps(0.5f);
+  __m256i words[4] = {c0, c1, c2, c3};
+  for (int word=0; word<4; word++) {
+    __m256 top = _mm256_cvtepi32_ps(_mm256_srli_epi32(words[word], 9));
+    _mm256_storeu_ps(out+word*8, _mm256_mul_ps(_mm256_add_ps(top, half), scale));
+  }
+}
+#endif
+
+typedef void (*UniformFunc)(uint32_t, uint64_t, uint32_t, float*);
+
+static UniformFunc pickUniform(const char** name) {
+#ifdef PHILOX_X86
+  if (__builtin_cpu_supports("avx2")) {
+    *name = "avx2";
+    return philoxUniform32AVX2;
+  }
+#endif
+  *name = "scalar";
+  return philoxUniform32Scalar;
+}
+
+static const char* uniformName = "";
+static const UniformFunc uniform = pickUniform(&uniformName);
+
+void philoxUniform32(uint32_t run, uint64_t event, uint32_t stream, float out[32]) {
+  uniform(run, event, stream, out);
+}
+
+const char* philoxImpl() {
+  return uniformName;
+}
@@ -0,0 +1,54 @@
+/*Philox.h
+ *Counter-based random numbers for the dithering in Rebin() and setParameters().
+ *Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3", SC11)
+ *turns a 128-bit counter and a 64-bit key into four random 32-bit words with no state
+ *carried between calls. The numbers for an event depend only on (run, event, stream,
+ *channel), so any thread can process any event and get bit-identical output.
+ *
+ *philoxUniform32() makes the 32 numbers for one stream of one event (a module's 32
+ *channels, or the draws of setParameters()). Channel c comes from block c%8, word c/8,
+ *so the AVX2 kernel computes the eight blocks side by side.
+ *
+ *Oct 2026
+ */
+
+#ifndef PHILOX_H
+#define PHILOX_H
+
+#include <cstdint>
+
+/*philoxBlock()
+ *One Philox4x32-10 block: ctr is replaced by the four output words
+ */
+inline void philoxBlock(std::uint32_t ctr[4], std::uint32_t k0, std::uint32_t k1) {
+  const std::uint32_t M0 = 0xD2511F53, M1 = 0xCD9E8D57;
+  const std::uint32_t W0 = 0x9E3779B9, W1 = 0xBB67AE85;
+  for (int round=0; round<10; round++) {
+    std::uint64_t p0 = (std::uint64_t)M0*ctr[0];
+    std::uint64_t p1 = (std::uint64_t)M1*ctr[2];
+    std::uint32_t c0 = (std::uint32_t)(p1 >> 32) ^ ctr[1] ^ k0;
+    std::uint32_t c2 = (std::uint32_t)(p0 >> 32) ^ ctr[3] ^ k1;
+    ctr[0] = c0;
+    ctr[1] = (std::uint32_t)p1;
+    ctr[2] = c2;
+    ctr[3] = (std::uint32_t)p0;
+    k0 += W0;
+    k1 += W1;
+  }
+}
+
+//uniform float in (0,1) from the top 23 bits, so the +0.5 stays exact: never exactly 0 or 1,
+//like TRandom3::Rndm()
+inline float philoxToFloat(std::uint32_t x) {
+  return ((x >> 9) + 0.5f)*(1.0f/8388608.0f);
+}
+
+//streams: one per module slot, then the setParameters() draws
+const std::uint32_t PHILOX_PARAMETER_STREAM = 0x100;
+
+void philoxUniform32(std::uint32_t run, std::uint64_t event, std::uint32_t stream, float out[32]);
+void philoxUniform32Scalar(std::uint32_t run, std::uint64_t event, std::uint32_t stream,
+                           float out[32]);
+const char* philoxImpl(); //name of the kernel philoxUniform32() dispatches to
+
+#endif
@@ -0,0 +1,69 @@
+/*RingSource.h
+ *Common interface for anything that hands out NSCLDAQ 11 ring items one at a time:
+ *EvtReader (memory-mapped, finished files), EvtStream (growing files, FIFOs, stdin) and
+ *CompressedEvtReader (gzip/xz/zstd files).
+ *
+ *Each ring item begins with an 8-byte header: uint32 size (bytes, including the header)
+ *and uint32 type (1 = BEGIN_RUN, 2 = END_RUN, 30 = PHYSICS_EVENT, etc.). The body starts
+ *with a body header whose first uint32 is its size in bytes, or a single zero word if there
+ *is none; ringPayload() finds what follows it.
+ *
+ *Oct 2026
+ */
+
+#ifndef RINGSOURCE_H
+#define RINGSOURCE_H
+
+#include <cstdint>
+#include <cstring>
+
+//largest ring item the streaming readers will wait for. NSCLDAQ ring items are bounded by
+//the ring buffer (a few MB), so a size field past this is corrupt data, not a big item.
+const std::uint32_t MAX_RING_SIZE = 64*1024*1024;
+
+struct RingItem {
+  std::uint32_t size; //total size in bytes, header included
+  std::uint32_t type;
+  const char* body; //first byte after the 8-byte header
+};
+
+class RingSource {
+  public:
+    virtual ~RingSource() {};
+    //false once there are no more complete ring items
+    virtual bool next(RingItem& item) = 0;
+    //true if the source ended part way through a ring item
+    virtual bool isTruncated() = 0;
+    //bytes of input taken in so far (compressed bytes for a compressed file), for progress
+    virtual std::uint64_t getPosition() = 0;
+    //true if ring items stay valid after the next call to next(), until the source is closed
+    virtual bool stableItems() { return false; };
+};
+
+//the body of a ring item after the body header, as 16-bit words: where the physics word
+//count or the BEGIN_RUN run number is. bytes is how much of the ring item is left from there.
+struct RingPayload {
+  const std::uint16_t* words;
+  std::uint32_t bytes;
+};
+
+/*ringPayload()
+ *Skips the body header of ring. Returns false, with an empty payload, if the body is too
+ *short to say how long its body header is, or the size given is odd, too small to hold
+ *itself, or runs past the end of the ring item. Nothing past the ring item is ever read.
+ */
+inline bool ringPayload(const RingItem& ring, RingPayload& payload) {
+  payload.words = nullptr;
+  payload.bytes = 0;
+  if (ring.size < 12) return false;
+  std::uint32_t bodySize = ring.size-8;
+  std::uint32_t bodyheader_size;
+  std::memcpy(&bodyheader_size, ring.body, 4);
+  std::uint32_t offset = bodyheader_size != 0 ? bodyheader_size : 4; //still skip the size word
+  if (offset < 4 || (offset & 1) || offset > bodySize) return false;
+  payload.words = (const std::uint16_t*)(ring.body+offset);
+  payload.bytes = bodySize-offset;
+  return true;
+}
+
+#endif
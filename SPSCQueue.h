@@ -0,0 +1,108 @@
+/*SPSCQueue.h
+ *Bounded lock-free queue for exactly one producer thread and one consumer thread.
+ *Used to connect the stages of the evt2root conversion pipeline and the decompression
+ *thread of CompressedEvtReader. Capacity is rounded up to a power of two.
+ *
+ *tryPush()/tryPop() never block. push() and pop() sleep on a condition variable while the
+ *queue is full/empty, and are woken by the other side's next pop/push; the mutex is only
+ *touched when a thread is actually waiting, so a queue that keeps moving stays lock-free.
+ *close() wakes and fails any waiting call, for a consumer that stops early.
+ *
+ *Oct 2026
+ */
+
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+
+template<typename T>
+class SPSCQueue {
+  public:
+    SPSCQueue(std::size_t capacity) : head(0), tail(0), waiters(0), closed(false) {
+      std::size_t size = 1;
+      while (size < capacity) size <<= 1;
+      buffer.resize(size);
+      mask = size-1;
+    };
+
+    bool tryPush(const T& item) {
+      std::size_t t = tail.load(std::memory_order_relaxed);
+      if (t - head.load(std::memory_order_acquire) > mask) return false; //full
+      buffer[t&mask] = item;
+      tail.store(t+1, std::memory_order_release);
+      return true;
+    };
+
+    bool tryPop(T& item) {
+      std::size_t h = head.load(std::memory_order_relaxed);
+      if (h == tail.load(std::memory_order_acquire)) return false; //empty
+      item = buffer[h&mask];
+      head.store(h+1, std::memory_order_release);
+      return true;
+    };
+
+    //waits while full; false (nothing pushed) once the queue is closed
+    bool push(const T& item) {
+      return wait([&]() { return tryPush(item); });
+    };
+
+    //waits while empty; false (item untouched) once the queue is closed
+    bool pop(T& item) {
+      return wait([&]() { return tryPop(item); });
+    };
+
+    T pop() {
+      T item = T();
+      pop(item);
+      return item;
+    };
+
+    void close() {
+      closed = true;
+      std::lock_guard<std::mutex> lock(mutex);
+      changed.notify_all();
+    };
+
+  private:
+    template<class Try>
+    bool wait(Try attempt) {
+      if (closed.load(std::memory_order_relaxed)) return false;
+      if (!attempt()) {
+        std::unique_lock<std::mutex> lock(mutex);
+        waiters.fetch_add(1);
+        //pairs with the fence in wake(): either we see the other side's move or it sees us
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool done = false;
+        changed.wait(lock, [&]() { return (done = attempt()) || closed; });
+        waiters.fetch_sub(1);
+        if (!done) return false;
+      }
+      wake();
+      return true;
+    };
+
+    void wake() {
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (waiters.load(std::memory_order_relaxed) == 0) return;
+      std::lock_guard<std::mutex> lock(mutex);
+      changed.notify_all();
+    };
+
+    std::vector<T> buffer;
+    std::size_t mask;
+    //producer and consumer indices live on separate cache lines
+    alignas(64) std::atomic<std::size_t> head;
+    alignas(64) std::atomic<std::size_t> tail;
+    //blocking push()/pop(): threads asleep in wait(), and close()
+    alignas(64) std::atomic<int> waiters;
+    std::atomic<bool> closed;
+    std::mutex mutex;
+    std::condition_variable changed;
+};
+
+#endif
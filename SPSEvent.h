@@ -0,0 +1,51 @@
+/*SPSEvent.h
+ *Storage for a single unpacked event: the raw channels of each module and the
+ *parameters built from them by the setup's compiled program (see ChannelMap.h). Kept as
+ *plain fixed-size arrays so events can be decoded on any thread and handed to the tree writer.
+ *
+ *Oct 2026
+ */
+
+#ifndef SPSEVENT_H
+#define SPSEVENT_H
+
+#include "Rtypes.h"
+#include "ChannelMap.h"
+
+struct SPSEvent {
+  static const int N_MODULES = SETUP_MAX_MODULES;
+
+  //run number and physics item number within the run; set by the reader, not Reset()
+  UInt_t run;
+  ULong64_t event;
+
+  //raw channels of each module slot, in the order of the setup's modules
+  Int_t modules[N_MODULES][32];
+  //bit i set if channel i of the module in that slot was read out this event
+  UInt_t fired[N_MODULES];
+  //OR of the UnpackError flags of each slot's block, and blocks with an unknown geo/id
+  UInt_t errors[N_MODULES];
+  UInt_t strayBlocks;
+
+  //derived: the setup's aliases and parameters, in the order they are declared. Every
+  //one in the setup is written by the calibration, so Reset() leaves them alone.
+  Int_t aliases[SETUP_MAX_ALIASES];
+  Float_t params[SETUP_MAX_PARAMS];
+  //bit k set if the setup's gate k rejected the event; also written by the calibration
+  UInt_t failedGates;
+
+  /* Reset()
+   * Each event needs to be processed separately; so clean the variables of the first
+   * nModules slots (the ones in the setup)
+   */
+  void Reset(int nModules = N_MODULES) {
+    for (int slot = 0; slot<nModules; slot++) {
+      for (int i = 0; i<32; i++) modules[slot][i] = -1000;
+      fired[slot] = 0;
+      errors[slot] = 0;
+    }
+    strayBlocks = 0;
+  };
+};
+
+#endif
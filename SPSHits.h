@@ -0,0 +1,95 @@
+/*SPSHits.h
+ *Reader helper for files written with the sparse output layout (./evt2root --layout sparse).
+ *The sparse tree stores only the channels that fired, as parallel hit_module/hit_channel/
+ *hit_value arrays. SPSHits expands each entry back into a 32-channel array per module,
+ *so analysis code written against the dense layout can keep asking for adc3[4]:
+ *
+ *  #include "SPSHits.h"
+ *  TTree* tree = (TTree*) file->Get("DataTree");
+ *  SPSHits hits(tree);
+ *  Int_t* adc3 = hits.module("adc3"); //nullptr if the file has no adc3
+ *  for (Long64_t i=0; i<tree->GetEntries(); i++) {
+ *    hits.GetEntry(i);
+ *    if (adc3[4] > 0) ...
+ *  }
+ *
+ *The modules are the setup's, named by the tree's "hit_modules" user info; hit_module
+ *indices past the end of it (or all of them, in a file without it) are named module<i>.
+ *Channels that did not fire read as -1000. The dense layout dithers them like every other
+ *channel, so there they read as -1000 or -999; test for a hit with > -999 in both.
+ *Header-only so it can be loaded straight into a ROOT macro.
+ *
+ *Oct 2026
+ */
+
+#ifndef SPSHITS_H
+#define SPSHITS_H
+
+#include "TTree.h"
+#include "TList.h"
+#include "TNamed.h"
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+class SPSHits {
+  public:
+    SPSHits(TTree* t) : tree(t) {
+      //the setup's module names, in hit_module order, and however many more the hits use
+      TNamed* info = (TNamed*) tree->GetUserInfo()->FindObject("hit_modules");
+      if (info) {
+        std::istringstream stream(info->GetTitle());
+        std::string name;
+        while (stream >> name) names.push_back(name);
+      }
+      size_t nModules = names.size();
+      if (tree->GetEntries() > 0) {
+        size_t used = (size_t) tree->GetMaximum("hit_module") + 1;
+        if (used > nModules) nModules = used;
+      }
+      for (size_t i=names.size(); i<nModules; i++) names.push_back("module" + std::to_string(i));
+      channels.assign(nModules*32, -1000);
+
+      size_t maxHits = nModules*32;
+      hit_module.resize(maxHits);
+      hit_channel.resize(maxHits);
+      hit_value.resize(maxHits);
+      tree->SetBranchAddress("nhits", &nhits);
+      tree->SetBranchAddress("hit_module", hit_module.data());
+      tree->SetBranchAddress("hit_channel", hit_channel.data());
+      tree->SetBranchAddress("hit_value", hit_value.data());
+    };
+
+    //32 channels of the named module, valid for the life of this reader; nullptr if the
+    //file has no module of that name
+    Int_t* module(const std::string& name) {
+      for (size_t i=0; i<names.size(); i++) {
+        if (names[i] == name) return &channels[i*32];
+      }
+      return nullptr;
+    };
+    Int_t* module(size_t index) { return index < names.size() ? &channels[index*32] : nullptr; };
+    const std::vector<std::string>& moduleNames() const { return names; };
+
+    Int_t GetEntry(Long64_t entry) {
+      Int_t bytes = tree->GetEntry(entry);
+      std::fill(channels.begin(), channels.end(), -1000);
+      for (Int_t i=0; i<nhits; i++) {
+        if (hit_module[i] < names.size() && hit_channel[i] < 32) {
+          channels[hit_module[i]*32 + hit_channel[i]] = hit_value[i];
+        }
+      }
+      return bytes;
+    };
+
+  private:
+    TTree* tree;
+    std::vector<std::string> names;
+    std::vector<Int_t> channels; //32 per module, by hit_module index
+    Int_t nhits = 0;
+    std::vector<UChar_t> hit_module, hit_channel;
+    std::vector<Int_t> hit_value;
+};
+
+#endif
@@ -10,16 +10,44 @@
  *Updated to properly address ringbuffers, cut down on dynamic memory allocation,
  *and remove dependance on stack ordering
  *Gordon M. April 2019
+ *
+ *evt files are now read through a memory map (EvtReader) instead of copying each ring
+ *item into a stack buffer
+ *Oct 2026
  */
 
 
 #include "SPSevt2root.h"
+#include "TNamed.h"
+#include "TList.h"
+#include "TBranch.h"
+#include "TObjArray.h"
+#include "TFileMerger.h"
 #include <iostream>
 #include <iomanip>
 #include <fstream>
 #include <sstream>
 #include <stdexcept>
 #include <unistd.h>
+#include <cstring>
+#include <cstdio>
+#include <cctype>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <chrono>
+#include <sys/stat.h>
+#include <csignal>
+#include "EvtStream.h"
+#include "EvtIndex.h"
+#include "Philox.h"
+#include "Calibration.h"
+#include "EvtGenerator.h"
+#include <algorithm>
+#include "SPSCQueue.h"
+#include "ROOT/RDataFrame.hxx"
+#include <array>
 
 using namespace std;
 
@@ -28,173 +56,718 @@ evt2root::evt2root() {
 
   cout << "Enter evt list  file: ";
   cin>>fileName;
-  
-  //Set the size of the vectors to match number of possible channels
-  adc1.resize(32); adc2.resize(32); adc3.resize(32); tdc1.resize(32); mtdc1.resize(32);
+  Init();
+}
+
+evt2root::evt2root(const string& listName, bool verb) :
+  fileName(listName), verbose(verb)
+{
+  Init();
+}
+
+/*Init()
+ *Shared setup for all constructors; starts from the built-in detector setup
+ */
+void evt2root::Init() {
+  rootFile = nullptr;
+  DataTree = nullptr;
+  RejectedTree = nullptr;
 
-  adc1_geo = 3;//Set geo addresses here
-  adc_geos.push_back(adc1_geo);
-  adc2_geo = 4;
-  adc_geos.push_back(adc2_geo);
-  adc3_geo = 5;
-  adc_geos.push_back(adc3_geo);
-  tdc1_geo = 8;
-  adc_geos.push_back(tdc1_geo);
-  mtdc1_id = 9;
-  rand = new TRandom3();
+  pendingEvents.resize(CALIB_BATCH);
+  pendingGood.resize(CALIB_BATCH);
+  nPending = 0;
+  calib.reset(new ParamBatch);
+  applySetup();
 
 }
+
+/*applySetup()
+ *Gives each module of the setup a slot, in the order they are declared; the unpackers map
+ *geo/id -> slot with a lookup table. Sizes the channel vectors and the calibration batch,
+ *and books the histograms.
+ */
+void evt2root::applySetup() {
+  adc_unpacker = ADCUnpacker();
+  mtdc_unpacker = mTDCUnpacker();
+  moduleNames.clear();
+  auto& modules = setup.getModules();
+  nModules = modules.size();
+  for (int slot=0; slot<nModules; slot++) {
+    if (modules[slot].mtdc) mtdc_unpacker.addModule(modules[slot].id, slot);
+    else adc_unpacker.addModule(modules[slot].id, slot);
+    moduleNames.push_back(modules[slot].name);
+  }
+  moduleBranches.assign(nModules, vector<Int_t>(32));
+  stats.setModules(moduleNames);
+  stats.setGates(setup.getGates());
+  setup.getProgram().prepare(*calib);
+  histograms.book(setup.getHistograms());
+}
 //destructor
 evt2root::~evt2root() {
-  delete rand;
-  delete rootFile;
   delete DataTree;
-}
-
-/* Reset()
- * Each event needs to be processed separately; so clean the variables
- */
-void evt2root::Reset() {
- 
-  for (int i = 0; i<32; i++) { 
-    adc1[i] = -1000;
-    adc2[i] = -1000;
-    adc3[i] = -1000;
-    tdc1[i] = -1000;
-    mtdc1[i] = -1000;
-  }
-  anode1 = -1000;
-  anode2 = -1000;
-  scint1 = -1000;
-  scint2 = -1000;
-  cathode = -1000;    
-  fp_plane1_tdiff = -1000.0;
-  fp_plane2_tdiff = -1000.0;
-  fp_plane1_tsum = -1000.0;
-  fp_plane2_tsum = -1000.0;
-  fp_plane1_tave = -1000.0;
-  fp_plane2_tave = -1000.0;
-  plastic_sum = -1000.0;
-  anode1_time = -1000.0;
-  anode2_time = -1000.0;
-  plastic_time = -1000.0;
-
+  delete RejectedTree;
+  delete rootFile;
 }
 
 /*Rebin()
  *Eliminates beating pattern from raw mtdc data
- *by accounting for binning uncertainty
+ *by accounting for binning uncertainty; r holds one uniform number per channel
  */
-void evt2root::Rebin(vector<Int_t> &module) {
+void evt2root::Rebin(Int_t* module, const Float_t* r) {
   for (unsigned int i=0; i<32; i++) {
     if(module[i] != 0) {
-      Float_t r = rand->Uniform(0.,1.0);
-      Float_t value = module[i]+r;
+      Float_t value = module[i]+r[i];
       module[i] = (Int_t) value;
     }
   }
 }
 
+//value of one program input for an event: the channel, or 1/0 for fired(MODULE[CHANNEL])
+static inline float inputValue(const ParamInput& input, const SPSEvent& ev) {
+  if (input.fired) return (ev.fired[input.slot] >> input.channel) & 1;
+  return ev.modules[input.slot][input.channel];
+}
+
 /*setParameters()
- *Does the heavy lifting of setting all non-raw channel paramters.
- */
-void evt2root::setParameters() {
-  Float_t r[4];
-  for (int i=0; i<4; i++) {
-    r[i] = rand->Rndm();//converting int to float; add uncert
-  }
-  Float_t mtdc102 = ((Float_t)mtdc1[2]+r[0])*nanos_per_chan; 
-  Float_t mtdc101 = ((Float_t)mtdc1[1]+r[1])*nanos_per_chan;
-  Float_t mtdc103 = ((Float_t)mtdc1[3]+r[2])*nanos_per_chan;
-  Float_t mtdc104 = ((Float_t)mtdc1[4]+r[3])*nanos_per_chan;
- 
-  fp_plane1_tdiff = (mtdc102-mtdc101)/2.0;
-  fp_plane1_tave = (mtdc102+mtdc101)/2.0;
-  fp_plane1_tsum = (mtdc102+mtdc101);
-  
-  fp_plane2_tdiff = (mtdc104-mtdc103)/2.0;
-  fp_plane2_tave = (mtdc104+mtdc103)/2.0;
-  fp_plane2_tsum = (mtdc104+mtdc103);
-   
-  anode1 = adc3[4];
-  anode2 = adc3[5];
-  scint1 = adc3[6];
-  scint2 = adc3[9];
-  cathode = adc3[8];
+ *Does the heavy lifting of setting all non-raw channel paramters: copies the aliased
+ *channels and runs the setup's compiled program on this event, gates included.
+ */
+void evt2root::setParameters(SPSEvent& ev) {
+  const ParamProgram& program = setup.getProgram();
+  float values[ParamProgram::MAX_COLUMNS];
+  if (program.getDraws() > 0) {
+    Float_t r[32];//converting int to float; add uncert
+    philoxUniform32(ev.run, ev.event, PHILOX_PARAMETER_STREAM, r);
+    for (int k=0; k<program.getDraws(); k++) values[program.drawColumn(k)] = r[k];
+  }
+  auto& inputs = program.getInputs();
+  for (size_t k=0; k<inputs.size(); k++) {
+    values[program.inputColumn(k)] = inputValue(inputs[k], ev);
+  }
+  program.evaluateOne(values);
+  for (size_t k=0; k<program.getOutputs(); k++) ev.params[k] = values[program.outputColumn(k)];
+  ev.failedGates = 0;
+  for (size_t k=0; k<program.getGates(); k++) {
+    if (values[program.gateColumn(k)] == 0) ev.failedGates |= 1u << k;
+  }
 
-  plastic_sum = ((Float_t)scint1+rand->Rndm())+((Float_t)scint2+rand->Rndm());
-  anode1_time = (Float_t)mtdc1[5]+rand->Rndm();
-  anode2_time = (Float_t)mtdc1[6]+rand->Rndm();
-  plastic_time = (Float_t)mtdc1[7]+rand->Rndm();
+  auto& aliases = setup.getAliases();
+  for (size_t k=0; k<aliases.size(); k++) {
+    ev.aliases[k] = ev.modules[aliases[k].slot][aliases[k].channel];
+  }
 
 }
 
 /*unpack()
- *This is where the file is actually parsed. Takes a short pointer and traverses the .evt file, 
+ *This is where the file is actually parsed. Takes the payload of a physics ring and traverses it, 
  *calling each of the necessary modules to check first if there is a matching header. If yes, 
  *being the parsing of the buffer. Checks to make sure its a valid geo/id
+ *Returns false if the physics ring is malformed and should not be written.
+ */
+bool evt2root::unpack(const RingPayload& payload, SPSEvent& ev) {
+
+  //the leading word counts the words after it, which have to be inside the ring item
+  if (payload.bytes < 2) return false;
+  const uint16_t* eventPointer = payload.words;
+  uint32_t numWords = *eventPointer;
+  if (2*(numWords+1) > payload.bytes) {//Incorrectly formated physics ring
+    return false;
+  }
+  const uint16_t* end =  eventPointer + numWords+1;
+  ParsedModuleEvent block; //one block's worth of decode storage, reused for every module
+
+  ev.Reset(nModules);//wipe variables
+
+  auto store = [&](const ParsedModuleEvent& parsed) {
+    if (parsed.s_slot >= 0) {
+      Int_t* module = ev.modules[parsed.s_slot];
+      UInt_t& fired = ev.fired[parsed.s_slot];
+      for (int i=0; i<parsed.s_nData; i++) {
+        module[parsed.s_data[i].first] = parsed.s_data[i].second;
+        fired |= 1u << parsed.s_data[i].first;
+      }
+      ev.errors[parsed.s_slot] |= parsed.s_errors;
+    } else {
+      ev.strayBlocks++;
+    }
+  };
+  //the vectorized pre-scan only pays off when there are long runs of words between
+  //module blocks; for a tightly packed stack the word-by-word walk is faster
+  if (vectorScan) forEachBlock(eventPointer+1, end, adc_unpacker, mtdc_unpacker, block, store);
+  else forEachBlockScalar(eventPointer+1, end, adc_unpacker, mtdc_unpacker, block, store);
+
+  return true;
+}
+
+/*calibrateBatch()
+ *Batched equivalent of Rebin() and setParameters() for n unpacked events, with identical
+ *results. Each module is dithered with the vector rebin kernel (unless dither is false, for
+ *channels read back from a tree, which already are); the program's channels and
+ *draws are gathered into the columns of work (prepared by the program), evaluated for all
+ *events at once, and the parameters scattered back. Like processEvent(), only touches the
+ *events and work.
  */
-void evt2root::unpack(uint16_t* eventPointer, uint32_t ringSize) {
+void evt2root::calibrateBatch(SPSEvent* events, size_t n, ParamBatch& work, bool dither) {
+  const ParamProgram& program = setup.getProgram();
+  auto& inputs = program.getInputs();
+  auto& aliases = setup.getAliases();
+  int nDraws = program.getDraws();
+  float* inputColumns[ParamProgram::MAX_COLUMNS];
+  float* drawColumns[ParamProgram::MAX_DRAWS];
+  float* outputColumns[SETUP_MAX_PARAMS];
+  float* gateColumns[SETUP_MAX_GATES];
+  for (size_t k=0; k<inputs.size(); k++) inputColumns[k] = work.column(program.inputColumn(k));
+  for (int k=0; k<nDraws; k++) drawColumns[k] = work.column(program.drawColumn(k));
+  for (size_t k=0; k<program.getOutputs(); k++) {
+    outputColumns[k] = work.column(program.outputColumn(k));
+  }
+  for (size_t k=0; k<program.getGates(); k++) gateColumns[k] = work.column(program.gateColumn(k));
 
-  uint16_t* iterPointer = eventPointer;
-  uint32_t numWords = *iterPointer++;
-  try {
-    if(numWords>ringSize) {
-      string size_err = "Incorrectly formated physics ring!";
-      throw size_err;
+  Float_t r[32];
+  for (size_t first=0; first<n; first+=CALIB_BATCH) {
+    SPSEvent* block = events+first;
+    work.n = n-first < CALIB_BATCH ? n-first : CALIB_BATCH;
+    for (size_t i=0; i<work.n; i++) {
+      SPSEvent& ev = block[i];
+      for (int slot=0; slot<nModules && dither; slot++) {
+        philoxUniform32(ev.run, ev.event, slot, r);
+        rebinModule(ev.modules[slot], r);
+      }
+      if (nDraws > 0) {
+        philoxUniform32(ev.run, ev.event, PHILOX_PARAMETER_STREAM, r);
+        for (int k=0; k<nDraws; k++) drawColumns[k][i] = r[k];
+      }
+      for (size_t k=0; k<inputs.size(); k++) {
+        inputColumns[k][i] = inputValue(inputs[k], ev);
+      }
+      for (size_t k=0; k<aliases.size(); k++) {
+        ev.aliases[k] = ev.modules[aliases[k].slot][aliases[k].channel];
+      }
     }
-  } catch (string size_err) {
-    //cout<<size_err<<endl; //for testing
+    program.evaluate(work);
+    for (size_t i=0; i<work.n; i++) {
+      SPSEvent& ev = block[i];
+      for (size_t k=0; k<program.getOutputs(); k++) ev.params[k] = outputColumns[k][i];
+      ev.failedGates = 0;
+      for (size_t k=0; k<program.getGates(); k++) {
+        if (gateColumns[k][i] == 0) ev.failedGates |= 1u << k;
+      }
+    }
+  }
+}
+
+/*processEvent()
+ *Full per-event chain short of the tree: unpack, rebin every module, build parameters.
+ *The dithering is keyed on (ev.run, ev.event), which the caller sets, so the result does
+ *not depend on which thread processes the event or in what order. Only touches ev and
+ *the calling thread's threadStats, so workers may call it concurrently with their own events.
+ */
+bool evt2root::processEvent(const RingPayload& payload, SPSEvent& ev, Telemetry& threadStats) {
+  {
+    StageTimer timer(threadStats, STAGE_DECODE);
+    if (!unpack(payload, ev)) return false;
+  }
+  StageTimer timer(threadStats, STAGE_CALIBRATE);
+  Float_t r[32];
+  for (int slot=0; slot<nModules; slot++) {
+    philoxUniform32(ev.run, ev.event, slot, r);
+    Rebin(ev.modules[slot], r);
+  }
+  setParameters(ev);
+  return true;
+}
+
+/*fillEvent()
+ *Tallies the module errors of a decoded event and fills it into the tree or RNTuple
+ *(unless there is none, with --no-tree), or counts it as malformed if unpack() rejected it. Events
+ *failing a gate are counted and only go to RejectedTree, if there is one.
+ */
+void evt2root::fillEvent(const SPSEvent& ev, bool good) {
+  if (!good) {
+    stats.malformed++;
+    return;
+  }
+  stats.countEvent(ev.errors, ev.strayBlocks);
+  if (ev.failedGates) {
+    stats.countRejected(ev.failedGates);
+    if (RejectedTree) fillRejected(ev);
     return;
   }
-  uint16_t* end =  eventPointer + numWords+1;
-  vector<ParsedmTDCEvent> mtdcData;
-  vector<ParsedADCEvent> adcData;
+  if (ntuple) ntuple->fill(ev);
+  else if (treeOutput) fillTree(ev);
+  stats.filled++;
+}
 
-  Reset();//wipe variables
+/*fillTree()
+ *Copies a processed event into the branch parameters and fills DataTree
+ */
+void evt2root::fillTree(const SPSEvent& ev) {
+  if (&ev != &treeEvent) treeEvent = ev;
+  if (layout == LAYOUT_SPARSE) {
+    //only channels that were read out: (module slot, channel, value)
+    nhits = 0;
+    for (int slot=0; slot<nModules; slot++) {
+      const Int_t* module = ev.modules[slot];
+      UInt_t fired = ev.fired[slot];
+      while (fired) {
+        int chan = __builtin_ctz(fired);
+        fired &= fired-1;
+        hit_module[nhits] = slot;
+        hit_channel[nhits] = chan;
+        hit_value[nhits] = module[chan];
+        nhits++;
+      }
+    }
+  } else {
+    for (int slot=0; slot<nModules; slot++) {
+      moduleBranches[slot].assign(ev.modules[slot], ev.modules[slot]+32);
+    }
+  }
+  DataTree->Fill();
+}
+
+/*fillRejected()
+ *Fills RejectedTree with an event that failed a gate
+ */
+void evt2root::fillRejected(const SPSEvent& ev) {
+  if (&ev != &treeEvent) treeEvent = ev;
+  RejectedTree->Fill();
+}
 
-  while (iterPointer<end){
-    //check if header matches; for adc looks like readout puts something like header
-    //after a EOE, skip those too
-    if (adc_unpacker.isHeader(*iterPointer) && *(iterPointer-1) != 0xffff) {
-      auto adc = adc_unpacker.parse(iterPointer-1, end, adc_geos);
-      adcData.push_back(adc.second);
-      iterPointer = adc.first;
-    } else if (mtdc_unpacker.isHeader(*iterPointer)) {
-      auto mtdc = mtdc_unpacker.parse(iterPointer-1, end, mtdc1_id);
-      mtdcData.push_back(mtdc.second);
-      iterPointer = mtdc.first;
-    } else iterPointer++;
+/*makeBranches()
+ *Attaches the branch parameters of this converter to a tree. The raw module channels are
+ *either dense 32-entry vectors per module or, for the sparse layout, one hit list of
+ *(hit_module, hit_channel, hit_value); the module names by hit_module index are stored
+ *in the tree's user info as "hit_modules". The tree of rejected events leaves out the raw
+ *channels and has failed_gates instead, bit k for the k-th gate of its "gates" user info.
+ */
+void evt2root::makeBranches(TTree* tree, bool rejected) {
+  //Add branches here
+  if (rejected) {
+    string names;
+    for (auto& name : setup.getGates()) names += (names.empty() ? "" : " ") + name;
+    tree->GetUserInfo()->Add(new TNamed("gates", names.c_str()));
+  } else if (layout == LAYOUT_SPARSE) {
+    tree->Branch("nhits", &nhits, "nhits/I");
+    tree->Branch("hit_module", hit_module, "hit_module[nhits]/b");
+    tree->Branch("hit_channel", hit_channel, "hit_channel[nhits]/b");
+    tree->Branch("hit_value", hit_value, "hit_value[nhits]/I");
+    string names;
+    for (auto& name : moduleNames) names += (names.empty() ? "" : " ") + name;
+    tree->GetUserInfo()->Add(new TNamed("hit_modules", names.c_str()));
+  } else {
+    for (int slot=0; slot<nModules; slot++) {
+      tree->Branch(moduleNames[slot].c_str(), &moduleBranches[slot]);
+    }
   }
+  tree->Branch("run", &treeEvent.run, "run/i");
+  tree->Branch("event", &treeEvent.event, "event/l");
+  if (rejected) tree->Branch("failed_gates", &treeEvent.failedGates, "failed_gates/i");
+  //aliases and parameters, in the order the setup declares them
+  for (auto& branch : setup.getBranches()) {
+    if (branch.alias) {
+      tree->Branch(branch.name.c_str(), &treeEvent.aliases[branch.index],
+                   (branch.name+"/I").c_str());
+    } else {
+      tree->Branch(branch.name.c_str(), &treeEvent.params[branch.index],
+                   (branch.name+"/F").c_str());
+    }
+  }
+}
 
-  for (auto& event : adcData) {
-    for (auto& chanData : event.s_data) {
-      if (event.s_geo == adc1_geo) adc1[chanData.first] = chanData.second;
-      else if (event.s_geo == adc2_geo) adc2[chanData.first] = chanData.second;
-      else if (event.s_geo == adc3_geo) adc3[chanData.first] = chanData.second;
-      else if (event.s_geo == tdc1_geo) tdc1[chanData.first] = chanData.second;
+/*makeTree()
+ *Creates DataTree (unless it is to be an RNTuple), and RejectedTree if rejected events are
+ *kept, with their branches and applies the output settings, compression included on
+ *each branch.
+ */
+void evt2root::makeTree() {
+  if (format == FORMAT_TTREE) {
+    DataTree = new TTree("DataTree", "DataTree");
+    makeBranches(DataTree, false);
+  }
+  if (keepRejected && !setup.getGates().empty()) {
+    RejectedTree = new TTree("RejectedTree", "Events rejected by the gates");
+    makeBranches(RejectedTree, true);
+  }
+  for (TTree* tree : {DataTree, RejectedTree}) {
+    if (!tree) continue;
+    tree->SetAutoFlush(output.autoFlush);
+    tree->SetBasketSize("*", output.basketSize);
+    for (auto* branch : *tree->GetListOfBranches()) {
+      static_cast<TBranch*>(branch)->SetCompressionSettings(output.compression());
     }
   }
+}
 
-  for(auto& event : mtdcData) {
-    for(auto& chanData : event.s_data) {
-      if (event.s_id == mtdc1_id) mtdc1[chanData.first] = chanData.second;
+/*copySettings()
+ *Gives a worker converter the same conversion and output options as this one
+ */
+void evt2root::copySettings(const evt2root& other) {
+  nThreads = other.nThreads;
+  batchCalib = other.batchCalib;
+  vectorScan = other.vectorScan;
+  layout = other.layout;
+  format = other.format;
+  output = other.output;
+  treeOutput = other.treeOutput;
+  keepRejected = other.keepRejected;
+  rollBytes = other.rollBytes;
+  setup = other.setup;
+  applySetup();
+}
+
+/*convertFile()
+ *Walks every ring item of one evt file, unpacking physics buffers into DataTree.
+ *gzip, xz and zstd compressed files are decompressed on the fly.
+ *Returns the number of physics buffers found, or -1 if the file could not be opened.
+ */
+int evt2root::convertFile(const EvtChunk& chunk) {
+  if (CompressedEvtReader::compressionOf(chunk.name) != COMPRESSION_NONE) {
+    //byte ranges come from the side-car index, which compressed files don't get
+    if (chunk.begin != 0 || chunk.end != SIZE_MAX) return -1;
+    CompressedEvtReader evtFile;
+    evtFile.setThreads(nThreads);
+    if (!evtFile.open(chunk.name)) {
+      cout<<evtFile.getError()<<endl;
+      return -1;
     }
+    int physBuffers = convertSource(evtFile, chunk);
+    if (!evtFile.getError().empty()) cout<<evtFile.getError()<<": "<<chunk.name<<endl;
+    return physBuffers;
   }
 
-  Rebin(mtdc1); Rebin(adc1); Rebin(adc2); Rebin(adc3); Rebin(tdc1);
-  setParameters();
-  DataTree->Fill();
+  EvtReader evtFile;
+  if (!evtFile.open(chunk.name)) return -1;
+  if ((chunk.begin != 0 || chunk.end != SIZE_MAX) && !evtFile.setRange(chunk.begin, chunk.end)) {
+    return -1;
+  }
+  return convertSource(evtFile, chunk);
+}
+
+/*convertSource()
+ *Converts an opened evt file, pipelined when there are worker threads
+ */
+int evt2root::convertSource(RingSource& evtFile, const EvtChunk& chunk) {
+  if (verbose) cout<<"evt file: "<<chunk.name<<endl;
+  if (nThreads > 1) return convertFilePipelined(evtFile, chunk);
+  return convertRings(evtFile, chunk.name, chunk.firstEvent, chunk.run);
+}
+
+//stands in for the ring handlers a loop has no use for
+struct IgnoreRing {
+  template <class... Args> void operator()(Args...) const {};
+};
+
+/*dispatchRing()
+ *The one place ring items are told apart, for every loop over an evt file. A physics item
+ *goes to physics(payload); a bad body header gives an empty payload, which unpack()
+ *rejects as malformed, so every physics item is seen and numbered. A BEGIN_RUN item goes
+ *to beginRun(run), unless it is too short to hold the run number, and END_RUN to endRun().
+ *Other ring types are ignored.
+ */
+template <class Physics, class BeginRun = IgnoreRing, class EndRun = IgnoreRing>
+static void dispatchRing(const RingItem& ring, Physics physics, BeginRun beginRun = BeginRun(),
+                         EndRun endRun = EndRun()) {
+  RingPayload payload; //where we start a phys event
+  bool good = ringPayload(ring, payload);
+  uint32_t run;
+  switch (ring.type) {
+    case 30: //Physics event buffer
+      physics(payload);
+      break;
+    case 1: //start of run buffer
+      if (!good || payload.bytes < 4) break;
+      memcpy(&run, payload.words, 4);
+      beginRun(run);
+      break;
+    case 2: //end of run buffer
+      endRun();
+      break;
+  }
+}
+
+/*announceRun()
+ *Reports the run number of a BEGIN_RUN item
+ */
+void evt2root::announceRun(uint32_t run, const string& evtName) {
+  if (!verbose) return;
+  cout <<"Run number = "<<run<<endl;
+  cout <<"Should match with file name: " <<evtName<<endl;
+}
+
+/*convertRings()
+ *Single-threaded ring loop shared by finished files and followed streams. Physics items
+ *are numbered from event in run, and from 0 again in the run of each BEGIN_RUN item. While
+ *following, the tree is checkpointed as events arrive and an END_RUN item ends the loop.
+ */
+int evt2root::convertRings(RingSource& evtFile, const string& evtName, uint64_t event,
+                           uint32_t run) {
+  int physBuffers = 0; //can report number of event buffers; consistency check with spectcl
+  bool endOfRun = false;
+  RingItem ring;
+  //the loop's time not spent in the other stages is charged to reading
+  auto busy = [this]() {
+    return stats.stageTicks[STAGE_DECODE] + stats.stageTicks[STAGE_CALIBRATE] +
+           stats.stageTicks[STAGE_FILL] + stats.stageTicks[STAGE_WRITE];
+  };
+  uint64_t loopStart = telemetryTicks();
+  uint64_t busyStart = busy();
+  uint64_t startPosition = evtFile.getPosition();
+  auto physics = [&](const RingPayload& payload) {
+    stats.physics++;
+    if (batchCalib) {
+      SPSEvent& ev = pendingEvents[nPending];
+      ev.run = run;
+      ev.event = event++;
+      {
+        StageTimer timer(stats, STAGE_DECODE);
+        pendingGood[nPending] = unpack(payload, ev);
+      }
+      if (++nPending == CALIB_BATCH) flushPending();
+    } else {
+      treeEvent.run = run;
+      treeEvent.event = event++;
+      bool good = processEvent(payload, treeEvent, stats);
+      StageTimer timer(stats, STAGE_FILL);
+      fillEvent(treeEvent, good);
+      if (good && !treeEvent.failedGates) histograms.fill(treeEvent);
+    }
+    physBuffers += 1;
+    if (verbose && (physBuffers & 1023) == 0) {
+      progress.update(inputDone + evtFile.getPosition() - startPosition, stats.physics);
+    }
+    if (following) checkpoint(1);
+  };
+  auto beginRun = [&](uint32_t runNum) {
+    run = runNum;
+    event = 0;
+    announceRun(run, evtName);
+  };
+  auto endRun = [&]() {
+    if (following) endOfRun = true;
+  };
+  while (!endOfRun && evtFile.next(ring)) {
+    stats.countRing(ring.type, ring.size);
+    dispatchRing(ring, physics, beginRun, endRun);
+  }
+  flushPending();
+  uint64_t loopTicks = telemetryTicks() - loopStart;
+  uint64_t busyTicks = busy() - busyStart;
+  stats.stageTicks[STAGE_READ] += loopTicks > busyTicks ? loopTicks - busyTicks : 0;
+  inputDone += evtFile.getPosition() - startPosition;
+  if (verbose) progress.clear();
+  if (evtFile.isTruncated()) {
+    stats.truncatedFiles++;
+    cout<<"Incomplete ring item at end of evt file: "<<evtName<<endl;
+  }
+  if (verbose) cout<<"Number of physics buffers: "<<physBuffers<<endl;
+  return physBuffers;
+}
+
+/*flushPending()
+ *Calibrates the events unpacked so far by convertRings() as one batch and fills them
+ */
+void evt2root::flushPending() {
+  if (nPending == 0) return;
+  {
+    StageTimer timer(stats, STAGE_CALIBRATE);
+    calibrateBatch(pendingEvents.data(), nPending, *calib, true);
+  }
+  StageTimer timer(stats, STAGE_FILL);
+  for (size_t i=0; i<nPending; i++) {
+    fillEvent(pendingEvents[i], pendingGood[i]);
+    if (pendingGood[i] && !pendingEvents[i].failedGates) histograms.fill(pendingEvents[i]);
+  }
+  nPending = 0;
+}
+
+/*Pipeline batch: a run of physics ring items (payloads in the evt mapping) and the
+ *events decoded from them. Batches cycle reader -> worker -> writer -> reader, so the
+ *storage is allocated once per file. A source that reuses its buffer (a compressed file)
+ *has the payloads copied into the batch's own storage instead.
+ */
+struct PipelineBatch {
+  vector<RingPayload> rings;
+  vector<SPSEvent> events;
+  vector<char> good;
+  size_t n = 0;
+  uint64_t bytes = 0; //input read up to the end of this batch, for the progress line
+  vector<uint16_t> storage; //copied payloads
+  vector<size_t> offsets; //where each payload starts in storage
+};
+
+static const size_t PIPELINE_BATCH = 256; //physics items per batch
+static const size_t PIPELINE_DEPTH = 4; //batches in flight per worker
+
+/*convertFilePipelined()
+ *Three-stage version of convertFile() for a single evt file. A reader thread slices ring
+ *items into batches, nThreads workers each unpack/rebin/build parameters for their
+ *batches with their own RNG and fill their own copy of the histograms, and this thread
+ *fills the tree. Batch k always goes to
+ *worker k%nThreads and is collected from the same worker in turn, so events are written
+ *in file order. Stages are joined by bounded single-producer/single-consumer queues.
+ */
+int evt2root::convertFilePipelined(RingSource& evtFile, const EvtChunk& chunk) {
+  const string& evtName = chunk.name;
+  bool copyRings = !evtFile.stableItems();
+
+  unsigned int nWorkers = nThreads;
+  size_t nBatches = nWorkers*PIPELINE_DEPTH;
+  vector<PipelineBatch> batches(nBatches);
+  for (auto& batch : batches) {
+    batch.rings.resize(PIPELINE_BATCH);
+    batch.events.resize(PIPELINE_BATCH);
+    batch.good.resize(PIPELINE_BATCH);
+    if (copyRings) batch.offsets.resize(PIPELINE_BATCH);
+  }
+
+  SPSCQueue<PipelineBatch*> freeQueue(nBatches);
+  for (auto& batch : batches) freeQueue.push(&batch);
+  vector<unique_ptr<SPSCQueue<PipelineBatch*>>> toWorker, toWriter;
+  for (unsigned int i=0; i<nWorkers; i++) {
+    toWorker.emplace_back(new SPSCQueue<PipelineBatch*>(nBatches));
+    toWriter.emplace_back(new SPSCQueue<PipelineBatch*>(nBatches));
+  }
+
+  //each stage counts into its own Telemetry; they are merged once the threads are joined
+  Telemetry readerStats;
+  vector<Telemetry> workerStats(nWorkers);
+  vector<HistogramSet> workerHists(nWorkers);
+  for (auto& hists : workerHists) hists.book(setup.getHistograms());
+  uint64_t startPosition = evtFile.getPosition(), inputRead = 0;
+
+  //copied payloads only get their final address once the batch is complete
+  auto seal = [&](PipelineBatch* batch) {
+    batch->bytes = evtFile.getPosition() - startPosition;
+    if (!copyRings) return;
+    for (size_t i=0; i<batch->n; i++) {
+      batch->rings[i].words = batch->storage.data() + batch->offsets[i];
+    }
+  };
+  auto take = [&]() {
+    PipelineBatch* batch = freeQueue.pop();
+    batch->n = 0;
+    batch->storage.clear();
+    return batch;
+  };
+
+  thread reader([&]() {
+    size_t next = 0; //batch sequence number
+    uint64_t event = chunk.firstEvent;
+    uint32_t run = chunk.run;
+    uint64_t start = telemetryTicks();
+    uint64_t waiting = 0; //time blocked on the queues is not reading
+    PipelineBatch* batch = take();
+    auto physics = [&](RingPayload payload) {
+      readerStats.physics++;
+      if (copyRings) {
+        //whole words only; unpack() never looks at an odd last byte
+        payload.bytes &= ~1u;
+        batch->offsets[batch->n] = batch->storage.size();
+        batch->storage.insert(batch->storage.end(), payload.words,
+                              payload.words + payload.bytes/2);
+      }
+      batch->rings[batch->n] = payload;
+      batch->events[batch->n].run = run;
+      batch->events[batch->n].event = event++;
+      if (++batch->n == PIPELINE_BATCH) {
+        seal(batch);
+        uint64_t waitStart = telemetryTicks();
+        toWorker[(next++)%nWorkers]->push(batch);
+        batch = take();
+        waiting += telemetryTicks() - waitStart;
+      }
+    };
+    auto beginRun = [&](uint32_t runNum) {
+      run = runNum;
+      event = 0;
+      announceRun(run, evtName);
+    };
+    RingItem ring;
+    while (evtFile.next(ring)) {
+      readerStats.countRing(ring.type, ring.size);
+      dispatchRing(ring, physics, beginRun);
+    }
+    readerStats.stageTicks[STAGE_READ] += telemetryTicks() - start - waiting;
+    seal(batch);
+    inputRead = batch->bytes;
+    if (batch->n > 0) toWorker[(next++)%nWorkers]->push(batch);
+    //one end marker per worker, in the order the writer will visit them
+    for (unsigned int i=0; i<nWorkers; i++) toWorker[(next++)%nWorkers]->push(nullptr);
+  });
+
+  vector<thread> workers;
+  for (unsigned int w=0; w<nWorkers; w++) {
+    workers.emplace_back([&, w]() {
+      unique_ptr<ParamBatch> work(new ParamBatch);
+      setup.getProgram().prepare(*work);
+      Telemetry& threadStats = workerStats[w];
+      HistogramSet& hists = workerHists[w];
+      PipelineBatch* batch;
+      while ((batch = toWorker[w]->pop()) != nullptr) {
+        if (batchCalib) {
+          for (size_t i=0; i<batch->n; i++) {
+            StageTimer timer(threadStats, STAGE_DECODE);
+            batch->good[i] = unpack(batch->rings[i], batch->events[i]);
+          }
+          StageTimer timer(threadStats, STAGE_CALIBRATE);
+          calibrateBatch(batch->events.data(), batch->n, *work, true);
+        } else {
+          for (size_t i=0; i<batch->n; i++) {
+            batch->good[i] = processEvent(batch->rings[i], batch->events[i], threadStats);
+          }
+        }
+        if (!hists.empty()) {
+          StageTimer timer(threadStats, STAGE_FILL);
+          for (size_t i=0; i<batch->n; i++) {
+            if (batch->good[i] && !batch->events[i].failedGates) hists.fill(batch->events[i]);
+          }
+        }
+        toWriter[w]->push(batch);
+      }
+      toWriter[w]->push(nullptr);
+    });
+  }
+
+  int physBuffers = 0;
+  size_t next = 0;
+  uint64_t physicsBefore = stats.physics;
+  PipelineBatch* batch;
+  while ((batch = toWriter[(next++)%nWorkers]->pop()) != nullptr) {
+    {
+      StageTimer timer(stats, STAGE_FILL);
+      for (size_t i=0; i<batch->n; i++) fillEvent(batch->events[i], batch->good[i]);
+    }
+    physBuffers += batch->n;
+    if (verbose) progress.update(inputDone + batch->bytes, physicsBefore + physBuffers);
+    freeQueue.push(batch);
+  }
+
+  reader.join();
+  for (auto& t : workers) t.join();
+  stats.merge(readerStats);
+  for (auto& threadStats : workerStats) stats.merge(threadStats);
+  for (auto& hists : workerHists) histograms.merge(hists);
+  inputDone += inputRead;
+  if (verbose) progress.clear();
+  if (evtFile.isTruncated()) {
+    stats.truncatedFiles++;
+    cout<<"Incomplete ring item at end of evt file: "<<evtName<<endl;
+  }
+  if (verbose) cout<<"Number of physics buffers: "<<physBuffers<<endl;
+  return physBuffers;
 }
 
 /*run()
  *function to be called at exectuion. Takes the list of evt files and opens them one at a time,
  *calls unpack() to unpack them, and then either completes or moves on to the next evt file.
+ *With more than one job the files are handed to runParallel() instead.
  *If a condition is not met, returns 0.
  */
 int evt2root::run() {
 
-  DataTree = new TTree("DataTree", "DataTree");
+  auto start = chrono::steady_clock::now();
   ifstream evtListFile;
   evtListFile.open(fileName.c_str());
   if (evtListFile.is_open()) {
@@ -204,88 +777,1423 @@ int evt2root::run() {
    return 0;
   }
 
-  string temp;
-  evtListFile>>temp;
-  char rootName[temp.size()+1];
-  strcpy(rootName, temp.c_str());
-  
-  rootFile = new TFile(rootName, "RECREATE");
-  cout<<"ROOT File: "<<temp<<endl;
-  
-  //Add branches here
-  DataTree->Branch("adc1", &adc1);
-  DataTree->Branch("adc2", &adc2);
-  DataTree->Branch("adc3", &adc3);
-  DataTree->Branch("tdc1", &tdc1);
-  DataTree->Branch("mtdc1", &mtdc1);
-  DataTree->Branch("fp_plane1_tdiff", &fp_plane1_tdiff, "fp_plane1_tdiff/F");
-  DataTree->Branch("fp_plane1_tsum", &fp_plane1_tsum, "fp_plane1_tsum/F");
-  DataTree->Branch("fp_plane1_tave", &fp_plane1_tdiff, "fp_plane1_tave/F");
-  DataTree->Branch("fp_plane2_tdiff", &fp_plane2_tdiff, "fp_plane2_tdiff/F");
-  DataTree->Branch("fp_plane2_tsum", &fp_plane2_tsum, "fp_plane2_tsum/F");
-  DataTree->Branch("fp_plane2_tave", &fp_plane2_tdiff, "fp_plane2_tave/F");
-  DataTree->Branch("anode1", &anode1, "anode1/I");
-  DataTree->Branch("anode2", &anode2, "anode2/I");
-  DataTree->Branch("scint1", &scint1, "scint1/I");
-  DataTree->Branch("scint2", &scint2, "scint2/I");
-  DataTree->Branch("cathode", &cathode, "cathode/I");
-  DataTree->Branch("plastic_sum", &plastic_sum, "plastic_sum/F");
-  DataTree->Branch("anode1_time", &anode1_time, "anode1_time/F");
-  DataTree->Branch("anode2_time", &anode2_time, "anode2_time/F");
-  DataTree->Branch("plastic_time", &plastic_time, "plastic_time/F");
-  
+  string rootName;
+  evtListFile>>rootName;
+  vector<string> evtNames;
   string evtName; 
-  evtListFile >> evtName;
-
-        
-  while (!evtListFile.eof()) {
-    ifstream evtFile;
-    evtFile.clear(); //make sure that evtFile is always empty before trying a new one
-    evtFile.open(evtName.c_str(), ios::binary);
-    int physBuffers = 0; //can report number of event buffers; consistency check with spectcl
-    if (evtFile.is_open()) {
-      cout<<"evt file: "<<evtName<<endl;
-      char buffer[8];
-      while (evtFile.read(buffer, 8)) {
-        uint32_t ringSize = *(uint32_t*)buffer-8;
-        char ringBuffer[ringSize];
-        evtFile.read(ringBuffer, ringSize);//read the remainder
-        uint32_t bodyheader_size = *(uint32_t*)(ringBuffer); //pull the bodyheader size (bytes)
-        uint16_t *eventPointer;
-        if (bodyheader_size != 0) {
-          eventPointer = ((uint16_t*)ringBuffer)+bodyheader_size/2;//where we start a phys event
-        } else {
-          eventPointer = ((uint16_t*)ringBuffer)+2; //still have to skip word telling size
+  while (evtListFile >> evtName) evtNames.push_back(evtName);
+
+  if (!outputName.empty()) rootName = outputName;
+  bool partial = firstFile > 0 || lastFile < evtNames.size() || nShards > 1;
+  if (partial) {
+    size_t total = evtNames.size();
+    evtNames = selectFiles(evtNames);
+    if (outputName.empty() && nShards > 1) rootName = shardName(rootName);
+    cout<<"Converting "<<evtNames.size()<<" of "<<total<<" evt files";
+    if (nShards > 1) cout<<" (shard "<<shardIndex<<" of "<<nShards<<")";
+    cout<<endl;
+  }
+
+  if (scanOnly) {
+    int status = runScan(evtNames);
+    writeTelemetry(rootName, chrono::duration<double>(chrono::steady_clock::now()-start).count());
+    return status;
+  }
+  if (format == FORMAT_RNTUPLE && !NTupleOutput::available()) {
+    cout<<"RNTuple output needs ROOT 6.34 or later"<<endl;
+    return 0;
+  }
+  if (format == FORMAT_RNTUPLE && (follow || !cacheDir.empty())) {
+    cout<<"RNTuple output can't be combined with --follow or --cache"<<endl;
+    return 0;
+  }
+  bool rolled = rollRuns || rollBytes > 0;
+  if (rolled && (follow || !cacheDir.empty() || indexOnly)) {
+    cout<<"Rolled output can't be combined with --follow, --cache or --build-index"<<endl;
+    return 0;
+  }
+  if (format == FORMAT_RNTUPLE && nJobs > 1 && !rolled) {
+    //the --jobs pieces are merged as trees; --threads still decodes in parallel
+    cout<<"RNTuple output is written by one job; ignoring --jobs"<<endl;
+    nJobs = 1;
+  }
+  if (benchmarkFormats) return runFormats(rootName, evtNames);
+  if (benchmarkProfiles) return runProfiles(rootName, evtNames);
+  if (!histograms.empty() && !cacheDir.empty()) {
+    cout<<"Histograms can't be combined with --cache: reused files have no events to fill"<<endl;
+    return 0;
+  }
+  if (!treeOutput && histograms.empty()) {
+    cout<<"--no-tree needs hist statements in the setup"<<endl;
+    return 0;
+  }
+  int status;
+  if (follow) status = runFollow(rootName, evtNames);
+  else if (!cacheDir.empty()) status = runCached(rootName, evtNames);
+  else if (indexOnly) status = buildIndexes(evtNames);
+  else if (rolled) status = runRolled(rootName, evtNames);
+  else {
+    vector<EvtChunk> chunks;
+    if (!makeChunks(evtNames, chunks)) status = 0;
+    else if (nJobs > 1 && chunks.size() > 1) status = runParallel(rootName, chunks);
+    else status = runSerial(rootName, chunks);
+  }
+  if (status && !indexOnly && !rolled && !histograms.empty()) writeHistograms(rootName);
+  if (status && !indexOnly) {
+    writeTelemetry(rootName, chrono::duration<double>(chrono::steady_clock::now()-start).count());
+  }
+  if (status && partial) status = writeManifest(rootName, evtNames);
+  return status;
+}
+
+//FNV-1a
+static uint64_t hashText(const string& text) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (unsigned char c : text) {
+    hash ^= c;
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+/*configKey()
+ *Everything about this converter that changes what it writes for a given evt file.
+ *Part of the cache key, so changing any of it reconverts every file.
+ */
+string evt2root::configKey() {
+  ostringstream key;
+  key<<"v3 layout="<<layout<<" compress="<<output.compression()
+     <<" basket="<<output.basketSize<<" flush="<<output.autoFlush
+     <<" setup="<<hex<<hashText(setup.getText());
+  return key.str();
+}
+
+/*cacheName()
+ *Cached root file for one evt file, named by a hash of its path, size, modification time,
+ *where its numbering starts (which depends on the files before a continuation file) and the
+ *converter configuration. Returns an empty string if the evt file can't be found.
+ */
+string evt2root::cacheName(const EvtChunk& chunk, const string& config) {
+  struct stat info;
+  if (stat(chunk.name.c_str(), &info) != 0) return "";
+  ostringstream key;
+  key<<chunk.name<<'\n'<<info.st_size<<'\n'<<info.st_mtim.tv_sec<<'.'<<info.st_mtim.tv_nsec
+     <<'\n'<<chunk.run<<' '<<chunk.firstEvent<<'\n'<<config;
+  uint64_t hash = hashText(key.str());
+  ostringstream name;
+  name<<cacheDir<<"/"<<hex<<setw(16)<<setfill('0')<<hash<<".root";
+  return name.str();
+}
+
+/*runCached()
+ *Incremental conversion. Each evt file is converted into its own root file in the cache
+ *directory, which is reused as long as the evt file and the configuration are unchanged.
+ *A cached file is written under a temporary name and renamed once complete, so an
+ *interrupted job resumes after the last finished file. Missing files are converted
+ *nJobs at a time, then all of the cached files are merged into rootName in list order.
+ */
+int evt2root::runCached(const string& rootName, const vector<string>& evtNames) {
+
+  string config = configKey();
+  vector<EvtChunk> chunks;
+  if (!fileStarts(evtNames, chunks)) return 0;
+  vector<string> parts(evtNames.size());
+  vector<size_t> missing;
+  struct stat info;
+  for (size_t i=0; i<evtNames.size(); i++) {
+    parts[i] = cacheName(chunks[i], config);
+    if (parts[i].empty()) {
+      cout<<"Unable to open evt file: "<<evtNames[i]<<endl;
+      return 0;
+    }
+    if (stat(parts[i].c_str(), &info) != 0) missing.push_back(i);
+  }
+  cout<<"Cache: "<<cacheDir<<" reusing "<<evtNames.size()-missing.size()<<" of "
+      <<evtNames.size()<<" evt files"<<endl;
+
+  if (!missing.empty()) {
+    unsigned int nWorkers = nJobs;
+    if (nWorkers > missing.size()) nWorkers = missing.size();
+    if (nWorkers > 1) ROOT::EnableThreadSafety();
+    atomic<size_t> next(0);
+    atomic<bool> failed(false);
+    mutex coutMutex;
+    auto work = [&]() {
+      size_t m;
+      while (!failed && (m = next++) < missing.size()) {
+        size_t i = missing[m];
+        string partial = parts[i] + ".part";
+        int status;
+        {
+          evt2root worker(fileName, verbose && nWorkers == 1);
+          worker.copySettings(*this);
+          status = worker.runSerial(partial, vector<EvtChunk>(1, chunks[i]));
+          lock_guard<mutex> guard(coutMutex);
+          stats.merge(worker.stats);
         }
-        auto bufferType = *(unsigned int*)(buffer+4);//determine what part of the file we're at
-        int runNum;
-
-        switch (bufferType) {
-          case 30: //Physics event buffer
-             unpack(eventPointer, ringSize);
-             physBuffers += 1;
-             cout<<"\rNumber of physics buffers: "<<physBuffers<<flush;
-             break;
-          case 1: //start of run buffer
-            runNum = *(eventPointer);
-            cout <<"Run number = "<<runNum<<endl;
-            cout <<"Should match with file name: " <<evtName<<endl;
-            break;
+        lock_guard<mutex> guard(coutMutex);
+        if (!status || rename(partial.c_str(), parts[i].c_str()) != 0) {
+          unlink(partial.c_str());
+          cout<<"Unable to convert evt file: "<<evtNames[i]<<endl;
+          failed = true;
+          return;
         }
+        cout<<"Cached: "<<evtNames[i]<<" -> "<<parts[i]<<endl;
       }
-    } else{
-      cout<<"Unable to open evt file: "<<evtName<<endl;
-      rootFile->Close();
+    };
+    vector<thread> workers;
+    for (unsigned int i=0; i<nWorkers; i++) workers.emplace_back(work);
+    for (auto& t : workers) t.join();
+    if (failed) return 0;
+  }
+
+  TFileMerger merger(false);
+  if (!merger.OutputFile(rootName.c_str(), "RECREATE", output.compression())) {
+    cout<<"Unable to open root file: "<<rootName<<endl;
+    return 0;
+  }
+  for (auto& part : parts) merger.AddFile(part.c_str());
+  cout<<"ROOT File: "<<rootName<<endl;
+  StageTimer timer(stats, STAGE_WRITE);
+  if (!merger.Merge()) {
+    cout<<"Merge failed"<<endl;
+    return 0;
+  }
+  cout<<"Conversion complete"<<endl;
+  return 1;
+}
+
+//raised by Ctrl-C while following a run
+static atomic<bool> stopFollowing(false);
+static void requestStop(int) { stopFollowing = true; }
+
+/*openEvt()
+ *A whole evt file as a ring item source, compressed or not; null if it can't be opened
+ */
+unique_ptr<RingSource> evt2root::openEvt(const string& evtName) {
+  if (CompressedEvtReader::compressionOf(evtName) != COMPRESSION_NONE) {
+    unique_ptr<CompressedEvtReader> reader(new CompressedEvtReader);
+    if (!reader->open(evtName)) return nullptr;
+    return std::move(reader);
+  }
+  unique_ptr<EvtReader> reader(new EvtReader);
+  if (!reader->open(evtName)) return nullptr;
+  return std::move(reader);
+}
+
+/*runScan()
+ *--scan: checks the evt files without converting them. Every ring item is walked and every
+ *physics item decoded, for the ring type counts, run numbers, module errors and channel
+ *occupancy, but nothing is calibrated and no root file is written. --jobs files are
+ *scanned at once; each file's line is printed in list order once all are done. A file
+ *that can't be opened fails the scan, but the others are still reported.
+ */
+int evt2root::runScan(const vector<string>& evtNames) {
+
+  vector<Telemetry> fileStats(evtNames.size());
+  unsigned int nWorkers = nJobs;
+  if (nWorkers > evtNames.size()) nWorkers = evtNames.size();
+  atomic<size_t> next(0);
+  auto work = [&]() {
+    evt2root worker(fileName, false);
+    worker.copySettings(*this);
+    size_t i;
+    while ((i = next++) < evtNames.size()) worker.scanFile(evtNames[i], fileStats[i]);
+  };
+  vector<thread> workers;
+  for (unsigned int i=0; i<nWorkers; i++) workers.emplace_back(work);
+  for (auto& t : workers) t.join();
+
+  int status = 1;
+  for (size_t i=0; i<evtNames.size(); i++) {
+    const Telemetry& file = fileStats[i];
+    if (!file.scanned) {
+      cout<<"Unable to open evt file: "<<evtNames[i]<<endl;
+      status = 0;
+      continue;
+    }
+    cout<<"evt file: "<<evtNames[i]<<" run";
+    for (auto run : file.runs) cout<<" "<<run;
+    if (file.runs.empty()) cout<<" -";
+    cout<<" Number of physics buffers: "<<file.physics<<" with module errors "
+        <<file.eventsWithErrors<<" malformed "<<file.malformed;
+    if (file.truncatedFiles) cout<<" (incomplete last ring item)";
+    cout<<endl;
+    stats.merge(file);
+  }
+  cout<<"Scan complete"<<endl;
+  return status;
+}
+
+/*scanFile()
+ *Walks one evt file for runScan(), counting into fileStats; false if it can't be opened
+ */
+bool evt2root::scanFile(const string& evtName, Telemetry& fileStats) {
+  fileStats.setModules(moduleNames);
+  unique_ptr<RingSource> evtFile = openEvt(evtName);
+  if (!evtFile) return false;
+  fileStats.scanned = true;
+  SPSEvent ev;
+  RingItem ring;
+  uint64_t start = telemetryTicks(), decoding = 0;
+  auto physics = [&](const RingPayload& payload) {
+    fileStats.physics++;
+    uint64_t decodeStart = telemetryTicks();
+    if (unpack(payload, ev)) {
+      fileStats.countEvent(ev.errors, ev.strayBlocks);
+      fileStats.countOccupancy(ev.fired);
+    } else {
+      fileStats.malformed++;
+    }
+    decoding += telemetryTicks() - decodeStart;
+  };
+  auto beginRun = [&](uint32_t run) { fileStats.runs.push_back(run); };
+  while (evtFile->next(ring)) {
+    fileStats.countRing(ring.type, ring.size);
+    dispatchRing(ring, physics, beginRun);
+  }
+  fileStats.stageTicks[STAGE_DECODE] += decoding;
+  fileStats.stageTicks[STAGE_READ] += telemetryTicks() - start - decoding;
+  if (evtFile->isTruncated()) fileStats.truncatedFiles++;
+  return true;
+}
+
+/*runOf()
+ *Run number of the BEGIN_RUN item an evt file starts with. Returns false if a physics item
+ *comes first (a continuation file of the run before) or the file can't be read.
+ */
+bool evt2root::runOf(const string& evtName, uint32_t& run) {
+  unique_ptr<RingSource> source = openEvt(evtName);
+  if (!source) return false;
+  RingItem ring;
+  bool found = false, physicsFirst = false;
+  while (!found && !physicsFirst && source->next(ring)) {
+    dispatchRing(ring, [&](const RingPayload&) { physicsFirst = true; },
+                 [&](uint32_t runNum) { run = runNum; found = true; });
+  }
+  return found;
+}
+
+/*runRolled()
+ *Rolled output: a root file per run (--roll-runs) and/or a new one whenever the current
+ *one passes rollBytes (--roll-size), instead of one file for the whole list. The evt files
+ *are grouped by run from their BEGIN_RUN items, a file without one belonging to the run
+ *before (and numbered on from it, see fileStarts()), and each group is converted by its own converter into its own files, --jobs
+ *groups at a time. Histograms go into each file with its own events. The files are listed
+ *in order in a TChain macro, see writeChain().
+ */
+int evt2root::runRolled(const string& rootName, const vector<string>& evtNames) {
+
+  vector<EvtChunk> chunks;
+  if (!makeChunks(evtNames, chunks)) return 0;
+  string base = rootName;
+  if (base.size() > 5 && base.compare(base.size()-5, 5, ".root") == 0) {
+    base.erase(base.size()-5);
+  }
+
+  //consecutive chunks of the same run; everything is one group when only rolling by size
+  vector<vector<EvtChunk>> groups;
+  vector<string> groupNames;
+  uint32_t run = 0;
+  for (auto& chunk : chunks) {
+    bool newRun = chunk.run != run;
+    run = chunk.run;
+    if (groups.empty() || (rollRuns && newRun)) {
+      groups.emplace_back();
+      groupNames.push_back(rollRuns ? base + "_run" + to_string(run) : base);
+    }
+    groups.back().push_back(chunk);
+  }
+
+  vector<vector<string>> written(groups.size());
+  unsigned int nWorkers = nJobs;
+  if (nWorkers > groups.size()) nWorkers = groups.size();
+  if (nWorkers > 1) ROOT::EnableThreadSafety();
+  atomic<size_t> next(0);
+  atomic<bool> failed(false);
+  mutex coutMutex;
+  auto work = [&]() {
+    size_t g;
+    while (!failed && (g = next++) < groups.size()) {
+      evt2root worker(fileName, verbose && nWorkers == 1);
+      worker.copySettings(*this);
+      int status = worker.runGroup(groupNames[g], groups[g], written[g]);
+      lock_guard<mutex> guard(coutMutex);
+      stats.merge(worker.stats);
+      if (!status) failed = true;
+    }
+  };
+  vector<thread> workers;
+  for (unsigned int i=0; i<nWorkers; i++) workers.emplace_back(work);
+  for (auto& t : workers) t.join();
+  if (failed) return 0;
+
+  vector<string> files;
+  for (auto& names : written) files.insert(files.end(), names.begin(), names.end());
+  if (!writeChain(rootName, files)) return 0;
+  cout<<"Conversion complete: "<<files.size()<<" root files"<<endl;
+  return 1;
+}
+
+/*runGroup()
+ *Converts one group of runRolled() into base.root, or base_part000.root, base_part001.root
+ *... when rolling by size. The size is checked between evt files (or pieces), so a file
+ *overshoots the cap by up to one of them. The names written are added to files.
+ */
+int evt2root::runGroup(const string& base, const vector<EvtChunk>& chunks, vector<string>& files) {
+  progress.start(chunkBytes(chunks));
+  size_t i = 0;
+  for (int part=0; i<chunks.size(); part++) {
+    string name = base + ".root";
+    if (rollBytes > 0) {
+      char number[16];
+      snprintf(number, sizeof(number), "_part%03d", part);
+      name = base + number + ".root";
+    }
+    if (!openOutput(name)) return 0;
+    while (i < chunks.size()) {
+      if (convertFile(chunks[i]) < 0) {
+        cout<<"Unable to open evt file: "<<chunks[i].name<<endl;
+        closeOutput(false);
+        return 0;
+      }
+      i++;
+      if (rollBytes > 0 && (uint64_t) rootFile->GetEND() >= rollBytes) break;
+    }
+    closeOutput(true);
+    if (!histograms.empty()) {
+      writeHistograms(name);
+      histograms.book(setup.getHistograms()); //the next file starts from empty histograms
+    }
+    files.push_back(name);
+  }
+  return 1;
+}
+
+/*writeChain()
+ *Writes <root file>_chain.C, a macro listing the rolled root files in order:
+ *  .x run_chain.C                    TChain of DataTree over all of them
+ *  ROOT::RDataFrame frame("DataTree", run_files());   after .L run_chain.C
+ *The second works for RNTuple output as well.
+ */
+int evt2root::writeChain(const string& rootName, const vector<string>& files) {
+  string base = rootName;
+  if (base.size() > 5 && base.compare(base.size()-5, 5, ".root") == 0) {
+    base.erase(base.size()-5);
+  }
+  //the function names come from the file name, so it has to be an identifier
+  size_t slash = base.rfind('/');
+  string name = base.substr(slash == string::npos ? 0 : slash+1);
+  for (char& c : name) {
+    if (!isalnum((unsigned char) c)) c = '_';
+  }
+  if (name.empty() || isdigit((unsigned char) name[0])) name = "_" + name;
+  string macroName = base.substr(0, slash == string::npos ? 0 : slash+1) + name + "_chain.C";
+
+  ofstream macro(macroName.c_str());
+  macro<<"//root files evt2root wrote for "<<rootName<<", in order"<<endl
+       <<"#include \"TChain.h\""<<endl
+       <<"#include <string>"<<endl
+       <<"#include <vector>"<<endl<<endl
+       <<"std::vector<std::string> "<<name<<"_files() {"<<endl
+       <<"  return {"<<endl;
+  for (auto& file : files) macro<<"    \""<<file<<"\","<<endl;
+  macro<<"  };"<<endl
+       <<"}"<<endl<<endl
+       <<"TChain* "<<name<<"_chain() {"<<endl
+       <<"  TChain* chain = new TChain(\"DataTree\");"<<endl
+       <<"  for (auto& file : "<<name<<"_files()) chain->Add(file.c_str());"<<endl
+       <<"  return chain;"<<endl
+       <<"}"<<endl;
+  if (!macro) {
+    cout<<"Unable to write chain macro: "<<macroName<<endl;
+    return 0;
+  }
+  cout<<"Chain macro: "<<macroName<<endl;
+  return 1;
+}
+
+/*runFollow()
+ *Live conversion. The list is converted as usual except for the last evt file, which is
+ *followed as NSCLDAQ writes it ("-" reads ring items from stdin). The tree lives in the
+ *output file from the start and is AutoSaved every followSeconds or followEvents events,
+ *so macros can open a consistent snapshot during the run. Following ends at the END_RUN
+ *item, when a FIFO/stdin writer closes, after followIdle seconds without data, or on Ctrl-C.
+ */
+int evt2root::runFollow(const string& rootName, const vector<string>& evtNames) {
+
+  if (evtNames.empty()) {
+    cout<<"No evt file to follow"<<endl;
+    return 0;
+  }
+  rootFile = new TFile(rootName.c_str(), "RECREATE", "", output.compression());
+  if (treeOutput) {
+    makeTree();
+    if (DataTree) DataTree->SetDirectory(rootFile);
+    if (RejectedTree) RejectedTree->SetDirectory(rootFile);
+  }
+  cout<<"ROOT File: "<<rootName<<endl;
+  progress.start(0);
+
+  //the followed file carries on from the ones before it until its own BEGIN_RUN
+  vector<EvtChunk> chunks;
+  uint32_t run = 0;
+  uint64_t event = 0;
+  int status = fileStarts(vector<string>(evtNames.begin(), evtNames.end()-1), chunks);
+  if (status && chunks.empty()) status = carryOn(earlierFiles, run, event);
+  else if (status) {
+    run = chunks.back().run;
+    event = chunks.back().firstEvent;
+    status = walkRun(chunks.back().name, run, event);
+  }
+  for (size_t i=0; i<chunks.size() && status; i++) {
+    if (convertFile(chunks[i]) < 0) {
+      cout<<"Unable to open evt file: "<<chunks[i].name<<endl;
+      status = 0;
+    }
+  }
+
+  EvtStream stream;
+  const string& name = evtNames.back();
+  if (status && CompressedEvtReader::compressionOf(name) != COMPRESSION_NONE) {
+    cout<<"Can't follow a compressed evt file: "<<name<<endl;
+    status = 0;
+  }
+  if (status && !stream.open(name)) {
+    cout<<"Unable to open evt file: "<<name<<endl;
+    status = 0;
+  }
+  if (status) {
+    stream.setFollow(true, followIdle);
+    stopFollowing = false;
+    stream.setStopFlag(&stopFollowing);
+    stream.setIdleCallback([this]() { checkpoint(0); });
+    auto oldHandler = signal(SIGINT, requestStop);
+    following = true;
+    unsaved = 0;
+    lastSave = chrono::steady_clock::now();
+    cout<<"Following evt file: "<<name<<" (Ctrl-C to stop)"<<endl;
+    convertRings(stream, name, event, run);
+    following = false;
+    signal(SIGINT, oldHandler);
+  }
+
+  {
+    StageTimer timer(stats, STAGE_WRITE);
+    if (DataTree) DataTree->Write("", TObject::kOverwrite);
+    if (RejectedTree) RejectedTree->Write("", TObject::kOverwrite);
+    rootFile->Close();
+  }
+  DataTree = nullptr;//owned by the file, which deleted it on closing
+  RejectedTree = nullptr;
+  if (status) cout<<"Conversion complete"<<endl;
+  return status;
+}
+
+/*checkpoint()
+ *Counts newly filled events while following, and AutoSaves the tree (and writes the
+ *histograms so far) once enough events or enough time have gone by since the last save.
+ */
+void evt2root::checkpoint(long newEvents) {
+  unsaved += newEvents;
+  if (unsaved == 0) return;
+  auto now = chrono::steady_clock::now();
+  if (unsaved >= followEvents || chrono::duration<double>(now-lastSave).count() >= followSeconds) {
+    flushPending();
+    StageTimer timer(stats, STAGE_WRITE);
+    if (DataTree) DataTree->AutoSave("SaveSelf");
+    if (RejectedTree) RejectedTree->AutoSave("SaveSelf");
+    if (!histograms.empty()) {
+      rootFile->cd();
+      histograms.write();
+      rootFile->SaveSelf();
+    }
+    unsaved = 0;
+    lastSave = now;
+  }
+}
+
+/*wholeFiles()
+ *One chunk per evt file, covering all of it, numbered from 0 in run 0
+ */
+vector<EvtChunk> evt2root::wholeFiles(const vector<string>& evtNames) {
+  vector<EvtChunk> chunks;
+  for (auto& name : evtNames) chunks.push_back(EvtChunk(name));
+  return chunks;
+}
+
+/*walkRun()
+ *Advances run and event over a whole evt file the way the converter numbers physics
+ *items: each takes the next event number, and a BEGIN_RUN item starts its run at 0.
+ *Returns false if the file can't be read.
+ */
+bool evt2root::walkRun(const string& evtName, uint32_t& run, uint64_t& event) {
+  unique_ptr<RingSource> source = openEvt(evtName);
+  if (!source) {
+    cout<<"Unable to open evt file: "<<evtName<<endl;
+    return false;
+  }
+  RingItem ring;
+  while (source->next(ring)) {
+    dispatchRing(ring, [&](const RingPayload&) { event++; },
+                 [&](uint32_t runNum) { run = runNum; event = 0; });
+  }
+  return true;
+}
+
+/*carryOn()
+ *Run and event number at the end of names, for a file that continues their last run.
+ *Only the files back to the last one that starts with a BEGIN_RUN are read; before the
+ *start of the list it is event 0 of run 0.
+ */
+bool evt2root::carryOn(const vector<string>& names, uint32_t& run, uint64_t& event) {
+  run = 0;
+  event = 0;
+  size_t first = names.size();
+  uint32_t started;
+  while (first > 0 && !runOf(names[first-1], started)) first--;
+  if (first > 0) first--;
+  for (size_t i=first; i<names.size(); i++) {
+    if (!walkRun(names[i], run, event)) return false;
+  }
+  return true;
+}
+
+/*fileStarts()
+ *One chunk per evt file, with the run and event number its first physics item gets, the
+ *same in every mode so the dithering doesn't depend on how the list is split. A file that
+ *starts with a BEGIN_RUN starts at event 0 of that run. A continuation file (physics items
+ *before any BEGIN_RUN) carries on from the end of the file before it in the list, which
+ *is then read to count its events; for the first file, the list entries before a --files
+ *range or shard are used. Returns false if one of the files that has to be read can't be.
+ */
+int evt2root::fileStarts(const vector<string>& evtNames, vector<EvtChunk>& chunks) {
+  chunks = wholeFiles(evtNames);
+  for (size_t i=0; i<chunks.size(); i++) {
+    EvtChunk& chunk = chunks[i];
+    if (runOf(chunk.name, chunk.run)) continue;
+    if (i == 0) {
+      if (!carryOn(earlierFiles, chunk.run, chunk.firstEvent)) return 0;
+      continue;
+    }
+    chunk.run = chunks[i-1].run;
+    chunk.firstEvent = chunks[i-1].firstEvent;
+    if (!walkRun(chunks[i-1].name, chunk.run, chunk.firstEvent)) return 0;
+  }
+  return 1;
+}
+
+/*buildIndexes()
+ *--build-index: makes sure every evt file has a current side-car index, and reports the
+ *ring items found by type and the scan rate.
+ */
+int evt2root::buildIndexes(const vector<string>& evtNames) {
+  for (auto& name : evtNames) {
+    if (CompressedEvtReader::compressionOf(name) != COMPRESSION_NONE) {
+      cout<<"Indexes need uncompressed evt files: "<<name<<endl;
+      return 0;
+    }
+    EvtIndex index;
+    auto start = chrono::steady_clock::now();
+    bool loaded = index.load(name);
+    if (!loaded && !index.build(name)) {
+      cout<<"Unable to open evt file: "<<name<<endl;
       return 0;
     }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now()-start).count();
+    cout<<"evt file: "<<name;
+    if (loaded) {
+      cout<<" index is current";
+    } else {
+      cout<<" indexed at "<<index.getFileSize()/1.0e6/seconds<<" MB/s";
+      if (!index.save(name)) cout<<" (unable to write "<<EvtIndex::indexName(name)<<")";
+    }
     cout<<endl;
-    evtFile.close();
-    evtFile.clear();
-    evtListFile >> evtName;
+    for (auto& type : index.getTypes()) {
+      cout<<"  ring type "<<type.first<<": "<<type.second.size()<<endl;
+    }
+  }
+  return 1;
+}
+
+/*runBefore()
+ *Numbering of a piece of a file that starts at offset. If a BEGIN_RUN item comes before it
+ *in the file, run becomes its run number and event the number of physics items between
+ *the two; otherwise they are left as they are at the start of the file.
+ */
+void evt2root::runBefore(const string& evtName, const EvtIndex& index, uint64_t offset,
+                         uint32_t& run, uint64_t& event) {
+  const vector<uint64_t>& begins = index.getOffsets(1);
+  const vector<uint64_t>& physics = index.getOffsets(30);
+  EvtReader reader;
+  if (!reader.open(evtName)) return;
+  //the last one that really holds a run number, as dispatchRing() sees them
+  for (auto after = upper_bound(begins.begin(), begins.end(), offset); after != begins.begin();
+       --after) {
+    RingItem ring;
+    bool found = false;
+    if (reader.setRange(*(after-1), SIZE_MAX) && reader.next(ring)) {
+      dispatchRing(ring, IgnoreRing(), [&](uint32_t runNum) { run = runNum; found = true; });
+    }
+    if (!found) continue;
+    event = lower_bound(physics.begin(), physics.end(), offset) -
+            upper_bound(physics.begin(), physics.end(), *(after-1));
+    return;
   }
+}
 
-  DataTree->Write();
-  rootFile->Close();
+/*makeChunks()
+ *Turns the evt list into the pieces to convert. Without --index or --events that is one
+ *piece per file. Otherwise each file's index is used to keep only the physics events in
+ *[firstEvent, lastEvent) (counted across the whole list from 0), and, with several jobs,
+ *to cut the files into byte ranges of whole ring items so that one large file can be
+ *shared among the workers. A piece that starts part way into a file has no BEGIN_RUN, so
+ *its run and first event number are worked out from the index and fileStarts().
+ */
+int evt2root::makeChunks(const vector<string>& evtNames, vector<EvtChunk>& chunks) {
+  chunks.clear();
+  vector<EvtChunk> starts;
+  if (!fileStarts(evtNames, starts)) return 0;
+  if (!useIndex && firstEvent == 0 && lastEvent == UINT64_MAX) {
+    chunks = starts;
+    return 1;
+  }
+
+  //the offset tables take 8 bytes per physics item, so only one file's is held at a time:
+  //a first pass for the counts, then each file's index is opened again to cut it up
+  vector<uint64_t> counts(evtNames.size());
+  uint64_t total = 0;
+  for (size_t i=0; i<evtNames.size(); i++) {
+    if (CompressedEvtReader::compressionOf(evtNames[i]) != COMPRESSION_NONE) {
+      cout<<"Indexes need uncompressed evt files: "<<evtNames[i]<<endl;
+      return 0;
+    }
+    EvtIndex index;
+    if (!index.open(evtNames[i])) {
+      cout<<"Unable to open evt file: "<<evtNames[i]<<endl;
+      return 0;
+    }
+    counts[i] = index.getOffsets(30).size();
+    total += counts[i];
+  }
+  uint64_t first = firstEvent < total ? firstEvent : total;
+  uint64_t last = lastEvent < total ? lastEvent : total;
+  if (last < first) last = first;
+  //aim for a few pieces per job, but not so small that the per-piece cost shows
+  uint64_t perChunk = nJobs > 1 ? (last-first)/(4*nJobs) : last-first;
+  if (perChunk < 10000) perChunk = 10000;
+
+  uint64_t seen = 0; //physics events in the files before this one
+  for (size_t i=0; i<evtNames.size(); i++) {
+    uint64_t n = counts[i];
+    uint64_t from = first > seen ? first-seen : 0;
+    uint64_t to = last > seen ? last-seen : 0;
+    if (to > n) to = n;
+    seen += n;
+    if (from >= to) continue;
+    EvtIndex index;
+    if (!index.open(evtNames[i]) || index.getOffsets(30).size() != n) {
+      cout<<"Unable to open evt file: "<<evtNames[i]<<endl;
+      return 0;
+    }
+    const vector<uint64_t>& physics = index.getOffsets(30);
+    for (uint64_t k=from; k<to; k+=perChunk) {
+      EvtChunk chunk;
+      chunk.name = evtNames[i];
+      //a whole file keeps its non-physics items (BEGIN_RUN etc.) in the first/last piece
+      chunk.begin = k == 0 ? 0 : physics[k];
+      uint64_t stop = k+perChunk < to ? k+perChunk : to;
+      chunk.end = stop < n ? physics[stop] : SIZE_MAX;
+      chunk.run = starts[i].run;
+      chunk.firstEvent = starts[i].firstEvent + k;
+      if (chunk.begin != 0) {
+        runBefore(evtNames[i], index, chunk.begin, chunk.run, chunk.firstEvent);
+      }
+      chunks.push_back(chunk);
+    }
+  }
+  if (firstEvent != 0 || lastEvent != UINT64_MAX) {
+    cout<<"Converting physics events "<<first<<" to "<<last<<" of "<<total<<endl;
+  }
+  return 1;
+}
+
+/*selectFiles()
+ *Applies the --files range and then the shard to the evt list. Shards are contiguous
+ *blocks whose sizes differ by at most one file, so merging the shards in index order
+ *keeps the list order. The entries before the selection are kept in earlierFiles, for
+ *numbering a selection that starts with a continuation file.
+ */
+vector<string> evt2root::selectFiles(const vector<string>& evtNames) {
+  size_t first = firstFile < evtNames.size() ? firstFile : evtNames.size();
+  size_t last = lastFile < evtNames.size() ? lastFile : evtNames.size();
+  if (last < first) last = first;
+  size_t n = last - first;
+  size_t begin = first + n*shardIndex/nShards;
+  size_t end = first + n*(shardIndex+1)/nShards;
+  earlierFiles.assign(evtNames.begin(), evtNames.begin()+begin);
+  return vector<string>(evtNames.begin()+begin, evtNames.begin()+end);
+}
+
+/*shardName()
+ *Output name for one shard: run.root -> run_shard3.root
+ */
+string evt2root::shardName(const string& rootName) {
+  string base = rootName;
+  if (base.size() > 5 && base.compare(base.size()-5, 5, ".root") == 0) {
+    base.erase(base.size()-5);
+  }
+  return base + "_shard" + to_string(shardIndex) + ".root";
+}
+
+/*writeManifest()
+ *Writes <root file>.manifest once a partial conversion has finished. It has the same
+ *format as an evt list (the root file, then the evt files that went into it), so it can be
+ *handed back to --list to redo the shard or to --merge to combine the shards.
+ */
+int evt2root::writeManifest(const string& rootName, const vector<string>& evtNames) {
+  string manifestName = rootName + ".manifest";
+  ofstream manifest(manifestName.c_str());
+  manifest<<rootName<<endl;
+  for (auto& name : evtNames) manifest<<name<<endl;
+  if (!manifest) {
+    cout<<"Unable to write manifest: "<<manifestName<<endl;
+    return 0;
+  }
+  cout<<"Manifest: "<<manifestName<<endl;
+  return 1;
+}
+
+/*chunkBytes()
+ *Total size of the pieces to convert, for the progress ETA
+ */
+uint64_t evt2root::chunkBytes(const vector<EvtChunk>& chunks) {
+  uint64_t total = 0;
+  struct stat info;
+  for (auto& chunk : chunks) {
+    if (stat(chunk.name.c_str(), &info) != 0) continue;
+    size_t end = chunk.end < (size_t) info.st_size ? chunk.end : info.st_size;
+    if (end > chunk.begin) total += end - chunk.begin;
+  }
+  return total;
+}
+
+/*writeTelemetry()
+ *Prints the conversion summary and writes it as JSON to <root file>.json (or the name
+ *given with --stats). A copy goes into the root file as the TNamed "telemetry", so the
+ *numbers stay with the data.
+ */
+void evt2root::writeTelemetry(const string& rootName, double seconds) {
+  if (verbose) stats.print(cout, seconds);
+  string json = stats.json(rootName, seconds);
+  string jsonName = statsName.empty() ? rootName + ".json" : statsName;
+  ofstream jsonFile(jsonName.c_str());
+  jsonFile<<json;
+  jsonFile.close();
+  if (!jsonFile) cout<<"Unable to write telemetry: "<<jsonName<<endl;
+  else cout<<"Telemetry: "<<jsonName<<endl;
+  if (scanOnly || rollRuns || rollBytes > 0) return; //no single root file to keep it in
+
+  TFile file(rootName.c_str(), "UPDATE");
+  if (file.IsZombie()) {
+    cout<<"Unable to store telemetry in root file: "<<rootName<<endl;
+    return;
+  }
+  file.cd();
+  TNamed("telemetry", json.c_str()).Write("", TObject::kOverwrite);
+  file.Close();
+}
+
+/*writeHistograms()
+ *Adds the histograms, merged over all threads and jobs, to the root file
+ */
+void evt2root::writeHistograms(const string& rootName) {
+  TFile file(rootName.c_str(), "UPDATE");
+  if (file.IsZombie()) {
+    cout<<"Unable to store histograms in root file: "<<rootName<<endl;
+    return;
+  }
+  file.cd();
+  StageTimer timer(stats, STAGE_WRITE);
+  histograms.write();
+  file.Close();
+  cout<<"Histograms: "<<setup.getHistograms().size()<<" written to "<<rootName<<endl;
+}
+
+/*merge()
+ *Combines the root files named by a set of shard manifests into one output file, in the
+ *order the manifests are given.
+ */
+int evt2root::merge(const string& rootName, const vector<string>& manifestNames) {
+  TFileMerger merger(false);
+  if (!merger.OutputFile(rootName.c_str(), "RECREATE", output.compression())) {
+    cout<<"Unable to open merged root file: "<<rootName<<endl;
+    return 0;
+  }
+  for (auto& manifestName : manifestNames) {
+    ifstream manifest(manifestName.c_str());
+    string shardRoot;
+    if (!(manifest>>shardRoot)) {
+      cout<<"Unable to read manifest: "<<manifestName<<endl;
+      return 0;
+    }
+    if (!merger.AddFile(shardRoot.c_str())) {
+      cout<<"Unable to open shard root file: "<<shardRoot<<endl;
+      return 0;
+    }
+  }
+  cout<<"Merging "<<manifestNames.size()<<" shards into "<<rootName<<endl;
+  if (!merger.Merge()) {
+    cout<<"Merge failed"<<endl;
+    return 0;
+  }
+  cout<<"Merge complete"<<endl;
+  return 1;
+}
+
+//entries each recompute() thread reads and calibrates per block
+static const Long64_t RECOMPUTE_SLICE = 16384;
+
+//the raw channels of a DataTree, read back by one recompute() thread through its own file
+struct RawReader {
+  unique_ptr<TFile> file;
+  TTree* tree = nullptr;
+  bool sparse = false;
+  //dense layout: one vector per setup slot
+  vector<vector<Int_t>> moduleData;
+  vector<vector<Int_t>*> modules;
+  //sparse layout: setup slot of each hit_module index in the file (-1 if not in the setup),
+  //and the other way round
+  vector<int> slotOf, storedSlot;
+  Int_t nhits = 0;
+  UChar_t hitModule[SPSEvent::N_MODULES*32], hitChannel[SPSEvent::N_MODULES*32];
+  Int_t hitValue[SPSEvent::N_MODULES*32];
+  UInt_t run = 0;
+  ULong64_t event = 0;
+};
+
+/*openRaw()
+ *Opens rootName's DataTree for reading the raw channels of the setup's modules, which are
+ *matched to the branches (or the "hit_modules" names) by name.
+ */
+bool evt2root::openRaw(RawReader& in, const string& rootName, string& error) {
+  in.file.reset(TFile::Open(rootName.c_str(), "READ"));
+  if (!in.file || in.file->IsZombie()) {
+    error = "Unable to open root file: " + rootName;
+    return false;
+  }
+  in.tree = in.file->Get<TTree>("DataTree");
+  if (!in.tree) {
+    error = "No DataTree TTree in " + rootName;
+    return false;
+  }
+  in.tree->SetBranchStatus("*", 0);
+  for (const char* name : {"run", "event"}) {
+    if (!in.tree->GetBranch(name)) {
+      error = rootName + " has no " + name + " branch";
+      return false;
+    }
+    in.tree->SetBranchStatus(name, 1);
+  }
+  in.tree->SetBranchAddress("run", &in.run);
+  in.tree->SetBranchAddress("event", &in.event);
+
+  in.sparse = in.tree->GetBranch("hit_module") != nullptr;
+  if (in.sparse) {
+    TObject* names = in.tree->GetUserInfo()->FindObject("hit_modules");
+    istringstream words(names ? static_cast<TNamed*>(names)->GetTitle() : "");
+    string name;
+    in.storedSlot.assign(nModules, -1);
+    while (words>>name) {
+      auto found = find(moduleNames.begin(), moduleNames.end(), name);
+      int slot = found == moduleNames.end() ? -1 : found-moduleNames.begin();
+      if (slot >= 0) in.storedSlot[slot] = in.slotOf.size();
+      in.slotOf.push_back(slot);
+    }
+    for (const char* branch : {"nhits", "hit_module", "hit_channel", "hit_value"}) {
+      in.tree->SetBranchStatus(branch, 1);
+    }
+    in.tree->SetBranchAddress("nhits", &in.nhits);
+    in.tree->SetBranchAddress("hit_module", in.hitModule);
+    in.tree->SetBranchAddress("hit_channel", in.hitChannel);
+    in.tree->SetBranchAddress("hit_value", in.hitValue);
+  } else {
+    in.moduleData.assign(nModules, vector<Int_t>(32));
+    in.modules.resize(nModules);
+    for (int slot=0; slot<nModules; slot++) in.modules[slot] = &in.moduleData[slot];
+  }
+  for (int slot=0; slot<nModules; slot++) {
+    const string& name = moduleNames[slot];
+    if (in.sparse ? in.storedSlot[slot] < 0 : !in.tree->GetBranch(name.c_str())) {
+      error = "Module " + name + " of the setup is not in " + rootName;
+      return false;
+    }
+    if (in.sparse) continue;
+    in.tree->SetBranchStatus(name.c_str(), 1);
+    in.tree->SetBranchAddress(name.c_str(), &in.modules[slot]);
+  }
+  return true;
+}
+
+/*readRaw()
+ *Reads one entry's raw channels back into ev, as unpack() and the dithering left them
+ */
+void evt2root::readRaw(RawReader& in, Long64_t entry, SPSEvent& ev) {
+  in.tree->GetEntry(entry);
+  ev.Reset(nModules);
+  ev.run = in.run;
+  ev.event = in.event;
+  if (in.sparse) {
+    //the channels that didn't fire were dithered too; redo that, then put the hits back
+    Float_t r[32];
+    for (int slot=0; slot<nModules; slot++) {
+      philoxUniform32(ev.run, ev.event, in.storedSlot[slot], r);
+      rebinModule(ev.modules[slot], r);
+    }
+    for (int h=0; h<in.nhits; h++) {
+      int slot = in.hitModule[h] < in.slotOf.size() ? in.slotOf[in.hitModule[h]] : -1;
+      if (slot < 0 || in.hitChannel[h] > 31) continue;
+      ev.modules[slot][in.hitChannel[h]] = in.hitValue[h];
+      ev.fired[slot] |= 1u << in.hitChannel[h];
+    }
+  } else {
+    for (int slot=0; slot<nModules; slot++) {
+      const vector<Int_t>& module = *in.modules[slot];
+      for (size_t chan=0; chan<32 && chan<module.size(); chan++) {
+        ev.modules[slot][chan] = module[chan];
+        //channels that didn't fire hold -1000, or -999 once dithered
+        if (module[chan] > -999) ev.fired[slot] |= 1u << chan;
+      }
+    }
+  }
+}
+
+/*recompute()
+ *Recomputes the aliases, parameters and gates of the current setup from the raw channels
+ *in rootName's DataTree, without going back to the evt files, and writes them to
+ *friendName (<root file>_params.root by default) as the tree Parameters, entry for entry
+ *with DataTree:
+ *  DataTree->AddFriend("Parameters", "run_params.root");  then Parameters.fp_plane1_tdiff
+ *The stored channels are already dithered and the parameter draws are redone with the same
+ *random numbers, so an unchanged setup reproduces the converter's values exactly. A
+ *friend can't drop entries, so failed_gates records the gates instead. Each of --threads
+ *threads reads, through its own file, a contiguous slice of every block of entries and
+ *calibrates it; the tree is then filled in entry order.
+ */
+int evt2root::recompute(const string& rootName, const string& friendName) {
+  string outName = friendName;
+  if (outName.empty()) {
+    string base = rootName;
+    if (base.size() > 5 && base.compare(base.size()-5, 5, ".root") == 0) {
+      base.erase(base.size()-5);
+    }
+    outName = base + "_params.root";
+  }
+  unsigned int nWorkers = nThreads;
+  if (nWorkers > 1) ROOT::EnableThreadSafety();
+  vector<RawReader> readers(nWorkers);
+  string error;
+  for (auto& reader : readers) {
+    if (!openRaw(reader, rootName, error)) {
+      cout<<error<<endl;
+      return 0;
+    }
+  }
+  Long64_t entries = readers[0].tree->GetEntries();
+
+  TFile friendFile(outName.c_str(), "RECREATE", "", output.compression());
+  TTree* params = new TTree("Parameters", "Parameters recomputed from DataTree");
+  params->SetDirectory(&friendFile);
+  makeBranches(params, true); //as RejectedTree: no raw channels, failed_gates
+  params->GetUserInfo()->Add(new TNamed("setup", setup.getText().c_str()));
+  params->SetAutoFlush(output.autoFlush);
+  params->SetAutoSave(output.autoSave);
+  cout<<"Recomputing "<<entries<<" entries of "<<rootName<<" into "<<outName<<" with "
+      <<nWorkers<<" threads"<<endl;
+
+  vector<SPSEvent> events(RECOMPUTE_SLICE*nWorkers);
+  vector<unique_ptr<ParamBatch>> work(nWorkers);
+  for (auto& batch : work) {
+    batch.reset(new ParamBatch);
+    setup.getProgram().prepare(*batch);
+  }
+  auto start = chrono::steady_clock::now();
+  for (Long64_t first=0; first<entries; first+=RECOMPUTE_SLICE*nWorkers) {
+    auto calibrate = [&](unsigned int w) {
+      Long64_t begin = first + w*RECOMPUTE_SLICE;
+      Long64_t end = begin+RECOMPUTE_SLICE < entries ? begin+RECOMPUTE_SLICE : entries;
+      SPSEvent* block = events.data() + w*RECOMPUTE_SLICE;
+      for (Long64_t i=begin; i<end; i++) readRaw(readers[w], i, block[i-begin]);
+      if (end <= begin) return;
+      if (batchCalib) calibrateBatch(block, end-begin, *work[w], false);
+      else for (Long64_t i=0; i<end-begin; i++) setParameters(block[i]);
+    };
+    vector<thread> workers;
+    for (unsigned int w=1; w<nWorkers; w++) workers.emplace_back(calibrate, w);
+    calibrate(0);
+    for (auto& t : workers) t.join();
+    Long64_t n = entries-first < RECOMPUTE_SLICE*nWorkers ? entries-first : RECOMPUTE_SLICE*nWorkers;
+    for (Long64_t i=0; i<n; i++) {
+      treeEvent = events[i];
+      params->Fill();
+    }
+  }
+  params->Write("", TObject::kOverwrite);
+  friendFile.Close();
+  double seconds = chrono::duration<double>(chrono::steady_clock::now()-start).count();
+  cout<<"Recompute complete: "<<entries<<" entries in "<<seconds<<" s"<<endl;
+  return 1;
+}
+
+/*openOutput()
+ *Creates rootName as the current output file with DataTree and RejectedTree in it (or the
+ *RNTuple). The trees live in the file from the start, so full baskets go straight to disk
+ *and memory stays flat however long the list is, and they are AutoSaved every
+ *output.autoSave entries: after a crash the file still holds the tree up to the last save.
+ */
+bool evt2root::openOutput(const string& rootName) {
+  rootFile = new TFile(rootName.c_str(), "RECREATE", "", output.compression());
+  if (treeOutput) {
+    makeTree();
+    for (TTree* tree : {DataTree, RejectedTree}) {
+      if (!tree) continue;
+      tree->SetDirectory(rootFile);
+      tree->SetAutoSave(output.autoSave);
+    }
+  }
+  if (verbose) cout<<"ROOT File: "<<rootName<<endl; //workers' files are reported by the caller
+  if (treeOutput && format == FORMAT_RNTUPLE) {
+    //the RNTuple is written into the file as it fills, so it needs the file first
+    string error;
+    ntuple.reset(new NTupleOutput);
+    if (!ntuple->open(*rootFile, setup, layout == LAYOUT_SPARSE, output, error)) {
+      cout<<error<<endl;
+      closeOutput(false);
+      return false;
+    }
+  }
+  return true;
+}
+
+/*closeOutput()
+ *Writes the trees (if save) and closes the current output file, which deletes them
+ */
+void evt2root::closeOutput(bool save) {
+  {
+    StageTimer timer(stats, STAGE_WRITE);
+    ntuple.reset(); //commits the last cluster and the footer
+    //overwrite the last AutoSave rather than leaving a second cycle
+    if (save && DataTree) DataTree->Write("", TObject::kOverwrite);
+    if (save && RejectedTree) RejectedTree->Write("", TObject::kOverwrite);
+    rootFile->Close();
+  }
+  delete rootFile;
+  rootFile = nullptr;
+  DataTree = nullptr;
+  RejectedTree = nullptr;
+}
+
+/*runSerial()
+ *Converts the evt files (or pieces of them) one after another into a single ROOT file.
+ */
+int evt2root::runSerial(const string& rootName, const vector<EvtChunk>& chunks) {
+
+  if (!openOutput(rootName)) return 0;
+  progress.start(chunkBytes(chunks));
+  
+  for (auto& chunk : chunks) {
+    if (convertFile(chunk) < 0) {
+      cout<<"Unable to open evt file: "<<chunk.name<<endl;
+      closeOutput(false);
+      return 0;
+    }
+  }
+
+  closeOutput(true);
+  cout<<"Conversion complete"<<endl;
+  return 1;
+}
+
+/*benchmark()
+ *Writes a synthetic evt file with EvtGenerator and times the converter on it: unpack()
+ *alone over the physics items already in memory, then the whole conversion to a root
+ *file with the current settings (threads, layout, output profile). Rates are in events/s
+ *and MB/s of ring items. The evt and root files are removed afterwards.
+ */
+int evt2root::benchmark(uint64_t nEvents, int multiplicity) {
+  const char* tmp = getenv("TMPDIR");
+  string base = string(tmp != nullptr && *tmp ? tmp : "/tmp") + "/evt2root_bench_" +
+                to_string(getpid());
+  string evtName = base + ".evt", rootName = base + ".root";
+  EvtGenerator generator;
+  generator.setMultiplicity(multiplicity);
+  if (!generator.write(evtName, nEvents)) {
+    cout<<"Unable to write evt file: "<<evtName<<endl;
+    unlink(evtName.c_str());
+    return 0;
+  }
+  struct stat info;
+  double fileMB = stat(evtName.c_str(), &info) == 0 ? info.st_size/1.0e6 : 0;
+  cout<<"Synthetic evt file: "<<evtName<<", "<<nEvents<<" physics events, "<<multiplicity
+      <<" hits per module, "<<fileMB<<" MB"<<endl;
+
+  //unpack() alone: physics items are collected first so reading isn't part of the time
+  EvtReader reader;
+  reader.open(evtName);
+  vector<RingPayload> items;
+  double physicsMB = 0;
+  RingItem ring;
+  while (reader.next(ring)) {
+    dispatchRing(ring, [&](const RingPayload& payload) {
+      items.push_back(payload);
+      physicsMB += ring.size/1.0e6;
+    });
+  }
+  SPSEvent ev;
+  long good = 0;
+  auto start = chrono::steady_clock::now();
+  for (auto& item : items) good += unpack(item, ev);
+  double seconds = chrono::duration<double>(chrono::steady_clock::now()-start).count();
+  cout<<"evt2root::unpack(): "<<items.size()/seconds<<" events/s, "<<physicsMB/seconds
+      <<" MB/s ("<<good<<" good events)"<<endl;
+  reader.close();
+
+  //end to end
+  bool wasVerbose = verbose;
+  verbose = false;
+  stats = Telemetry();
+  stats.setModules(moduleNames);
+  start = chrono::steady_clock::now();
+  int status = runSerial(rootName, wholeFiles(vector<string>(1, evtName)));
+  seconds = chrono::duration<double>(chrono::steady_clock::now()-start).count();
+  verbose = wasVerbose;
+  delete DataTree;
+  delete RejectedTree;
+  delete rootFile;
+  DataTree = nullptr;
+  RejectedTree = nullptr;
+  rootFile = nullptr;
+  if (status) {
+    cout<<"Conversion ("<<nThreads<<" threads, "<<output.compression()<<"): "
+        <<nEvents/seconds<<" events/s, "<<fileMB/seconds<<" MB/s"<<endl;
+    stats.print(cout, seconds);
+  }
+  unlink(evtName.c_str());
+  unlink(rootName.c_str());
+  return status;
+}
+
+/*runProfiles()
+ *Converts the list once with each output profile and reports write time and file size,
+ *so the profiles can be checked against real data. The trial ROOT files are removed.
+ */
+int evt2root::runProfiles(const string& rootName, const vector<string>& evtNames) {
+
+  const char* profiles[] = {"quicklook", "default", "archival"};
+  double inputMB = 0;
+  struct stat info;
+  for (auto& name : evtNames) {
+    if (stat(name.c_str(), &info) == 0) inputMB += info.st_size/1.0e6;
+  }
+
+  bool wasVerbose = verbose;
+  verbose = false;
+  cout<<left<<setw(12)<<"profile"<<setw(14)<<"compression"<<setw(12)<<"time (s)"
+      <<setw(12)<<"MB/s in"<<setw(12)<<"MB out"<<"ratio"<<endl;
+  for (auto* profile : profiles) {
+    output.setProfile(profile);
+    string trialName = rootName + "." + profile;
+    auto start = chrono::steady_clock::now();
+    vector<EvtChunk> chunks;
+    int status = fileStarts(evtNames, chunks);
+    if (status) {
+      status = nJobs > 1 && chunks.size() > 1 ? runParallel(trialName, chunks) :
+                                                 runSerial(trialName, chunks);
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now()-start).count();
+    delete DataTree;
+    delete RejectedTree;
+    delete rootFile;
+    DataTree = nullptr;
+    RejectedTree = nullptr;
+    rootFile = nullptr;
+    if (!status) {
+      verbose = wasVerbose;
+      return 0;
+    }
+    double outputMB = stat(trialName.c_str(), &info) == 0 ? info.st_size/1.0e6 : 0;
+    unlink(trialName.c_str());
+    cout<<left<<setw(12)<<profile<<setw(14)<<output.compression()<<setw(12)<<seconds
+        <<setw(12)<<inputMB/seconds<<setw(12)<<outputMB
+        <<(outputMB > 0 ? inputMB/outputMB : 0)<<endl;
+  }
+  verbose = wasVerbose;
+  return 1;
+}
+
+/*runFormats()
+ *Converts the list once as a TTree and once as an RNTuple with the current output
+ *settings and layout, and reports write time, file size and the time RDataFrame takes to
+ *read every field back. Both are written by one job (decoding may still use --threads), so
+ *only the output format differs. The trial ROOT files are removed.
+ */
+int evt2root::runFormats(const string& rootName, const vector<string>& evtNames) {
+
+  if (!NTupleOutput::available()) {
+    cout<<"RNTuple output needs ROOT 6.34 or later"<<endl;
+    return 0;
+  }
+  double inputMB = 0;
+  struct stat info;
+  for (auto& name : evtNames) {
+    if (stat(name.c_str(), &info) == 0) inputMB += info.st_size/1.0e6;
+  }
+
+  OutputFormat wasFormat = format;
+  bool wasVerbose = verbose;
+  verbose = false;
+  cout<<left<<setw(10)<<"format"<<setw(12)<<"write (s)"<<setw(12)<<"MB/s in"<<setw(12)
+      <<"MB out"<<setw(12)<<"read (s)"<<"MB/s read"<<endl;
+  int status = 1;
+  for (OutputFormat trial : {FORMAT_TTREE, FORMAT_RNTUPLE}) {
+    format = trial;
+    const char* name = trial == FORMAT_TTREE ? "ttree" : "rntuple";
+    string trialName = rootName + "." + name;
+    auto start = chrono::steady_clock::now();
+    vector<EvtChunk> chunks;
+    status = fileStarts(evtNames, chunks) && runSerial(trialName, chunks);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now()-start).count();
+    delete DataTree;
+    delete RejectedTree;
+    delete rootFile;
+    DataTree = nullptr;
+    RejectedTree = nullptr;
+    rootFile = nullptr;
+    if (!status) break;
+    double outputMB = stat(trialName.c_str(), &info) == 0 ? info.st_size/1.0e6 : 0;
+    double readSeconds = readBack(trialName);
+    unlink(trialName.c_str());
+    cout<<left<<setw(10)<<name<<setw(12)<<seconds<<setw(12)<<inputMB/seconds<<setw(12)
+        <<outputMB<<setw(12)<<readSeconds<<outputMB/readSeconds<<endl;
+  }
+  format = wasFormat;
+  verbose = wasVerbose;
+  return status;
+}
+
+template <class Column>
+static void bookSums(ROOT::RDataFrame& frame, const vector<string>& columns,
+                     vector<ROOT::RDF::RResultPtr<double>>& sums) {
+  for (auto& column : columns) sums.push_back(frame.Sum<Column, double>(column));
+}
+
+/*readBack()
+ *Seconds RDataFrame takes, single threaded, to sum every field of DataTree in rootName (the
+ *whole of each module, or the hit values) in one event loop. The raw channels are typed
+ *as each format stores them.
+ */
+double evt2root::readBack(const string& rootName) {
+  auto start = chrono::steady_clock::now();
+  ROOT::RDataFrame frame("DataTree", rootName);
+  vector<ROOT::RDF::RResultPtr<double>> sums;
+  vector<string> raw = layout == LAYOUT_SPARSE ? vector<string>(1, "hit_value") : moduleNames;
+  if (format == FORMAT_TTREE) bookSums<ROOT::RVec<Int_t>>(frame, raw, sums);
+  else if (layout == LAYOUT_SPARSE) bookSums<vector<Int_t>>(frame, raw, sums);
+  else bookSums<array<Int_t, 32>>(frame, raw, sums);
+  vector<string> aliases, params;
+  for (auto& branch : setup.getBranches()) (branch.alias ? aliases : params).push_back(branch.name);
+  bookSums<Int_t>(frame, aliases, sums);
+  bookSums<Float_t>(frame, params, sums);
+  bookSums<UInt_t>(frame, vector<string>(1, "run"), sums);
+  bookSums<ULong64_t>(frame, vector<string>(1, "event"), sums);
+  sums[0].GetValue(); //runs the loop for all of them
+  return chrono::duration<double>(chrono::steady_clock::now()-start).count();
+}
+
+/*runParallel()
+ *Converts several evt files (or indexed pieces of files) at once. Each worker thread takes
+ *the next unclaimed piece and converts it with its own converter (unpackers, branch
+ *parameters, tree) into a temporary root file next to rootName. Once all are done the
+ *pieces are merged into rootName in list order, as runCached() does, so the output is
+ *the same whatever order the workers finished in.
+ */
+int evt2root::runParallel(const string& rootName, const vector<EvtChunk>& chunks) {
+
+  ROOT::EnableThreadSafety();
+  unsigned int nWorkers = nJobs;
+  if (nWorkers > chunks.size()) nWorkers = chunks.size();
+  cout<<"Converting "<<chunks.size()<<" evt files or pieces with "<<nWorkers<<" jobs"<<endl;
+
+  vector<string> parts(chunks.size());
+  for (size_t i=0; i<chunks.size(); i++) parts[i] = rootName + ".part" + to_string(i);
+  auto removeParts = [&]() {
+    for (auto& part : parts) unlink(part.c_str());
+  };
+
+  atomic<size_t> nextFile(0);
+  atomic<bool> failed(false);
+  mutex coutMutex;
+  uint64_t totalBytes = chunkBytes(chunks), doneBytes = 0; //guarded by coutMutex
+  auto start = chrono::steady_clock::now();
+
+  auto work = [&]() {
+    size_t i;
+    while (!failed && (i = nextFile++) < chunks.size()) {
+      const EvtChunk& chunk = chunks[i];
+      evt2root worker(fileName, false);
+      worker.copySettings(*this);
+      int physBuffers = -1;
+      if (worker.openOutput(parts[i])) {
+        physBuffers = worker.convertFile(chunk);
+        worker.closeOutput(physBuffers >= 0);
+      }
+      lock_guard<mutex> guard(coutMutex);
+      stats.merge(worker.stats);
+      histograms.merge(worker.histograms);
+      if (physBuffers < 0) {
+        cout<<"Unable to convert evt file: "<<chunk.name<<endl;
+        failed = true;
+        break;
+      }
+      doneBytes += worker.inputDone;
+      cout<<"evt file: "<<chunk.name;
+      if (chunk.begin != 0 || chunk.end != SIZE_MAX) {
+        cout<<" bytes "<<chunk.begin<<"-";
+        if (chunk.end == SIZE_MAX) cout<<"end";
+        else cout<<chunk.end;
+      }
+      cout<<" Number of physics buffers: "<<physBuffers
+          <<progressETA(chrono::duration<double>(chrono::steady_clock::now()-start).count(),
+                        doneBytes, totalBytes)<<endl;
+    }
+  };
+
+  vector<thread> workers;
+  for (unsigned int i=0; i<nWorkers; i++) workers.emplace_back(work);
+  for (auto& t : workers) t.join();
+  if (failed) {
+    removeParts();
+    return 0;
+  }
+
+  TFileMerger merger(false);
+  if (!merger.OutputFile(rootName.c_str(), "RECREATE", output.compression())) {
+    cout<<"Unable to open root file: "<<rootName<<endl;
+    removeParts();
+    return 0;
+  }
+  for (auto& part : parts) merger.AddFile(part.c_str());
+  cout<<"ROOT File: "<<rootName<<endl;
+  bool merged;
+  {
+    StageTimer timer(stats, STAGE_WRITE);
+    merged = merger.Merge();
+  }
+  removeParts();
+  if (!merged) {
+    cout<<"Merge failed"<<endl;
+    return 0;
+  }
   cout<<"Conversion complete"<<endl;
   return 1;
 }
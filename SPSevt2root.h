@@ -21,40 +21,211 @@
 #include "TTree.h"
 #include <vector>
 #include <cstdint>
+#include <chrono>
 #include "ADCUnpacker.h"
 #include "mTDCUnpacker.h"
-#include "TRandom3.h"
+#include "WordScan.h"
+#include "EvtReader.h"
+#include "CompressedEvtReader.h"
+#include "SPSEvent.h"
+#include "OutputSettings.h"
+#include "EvtIndex.h"
+#include "Calibration.h"
+#include "ChannelMap.h"
+#include "Histograms.h"
+#include "NTupleOutput.h"
+#include "Telemetry.h"
+#include <memory>
 
 using namespace std;
 
+//a byte range of one evt file: whole ring items in [begin, end). run and firstEvent are the
+//run and event number of the first physics item in it, until a BEGIN_RUN starts a new run
+//(see evt2root::fileStarts()).
+struct EvtChunk {
+  EvtChunk(const string& n = "") : name(n) {};
+  string name;
+  size_t begin = 0;
+  size_t end = SIZE_MAX;
+  uint64_t firstEvent = 0;
+  uint32_t run = 0;
+};
+
+struct RawReader;
+
+enum OutputLayout {
+  LAYOUT_DENSE, //32-entry vector per module, -1000 where nothing was read out
+  LAYOUT_SPARSE //only channels that fired, as (module, channel, value) hit lists
+};
+
+enum OutputFormat {
+  FORMAT_TTREE,  //DataTree is a TTree
+  FORMAT_RNTUPLE //DataTree is an RNTuple with the same fields (NTupleOutput)
+};
+
 class evt2root {
 
   public:
     evt2root();
+    evt2root(const string& listName, bool verb = true);
     ~evt2root();
     int run();
+    void setJobs(int n) { nJobs = n > 0 ? n : 1; };
+    void setThreads(int n) { nThreads = n > 0 ? n : 1; };
+    void setVectorScan(bool on) { vectorScan = on; };
+    void setBatchCalibration(bool on) { batchCalib = on; };
+    void setLayout(OutputLayout l) { layout = l; };
+    void setFormat(OutputFormat f) { format = f; };
+    void setTreeOutput(bool on) { treeOutput = on; };
+    void setKeepRejected(bool on) { keepRejected = on; };
+    void setOutput(const OutputSettings& o) { output = o; };
+    void setBenchmarkProfiles(bool on) { benchmarkProfiles = on; };
+    void setBenchmarkFormats(bool on) { benchmarkFormats = on; };
+    void setOutputName(const string& name) { outputName = name; };
+    void setFileRange(size_t first, size_t last) { firstFile = first; lastFile = last; };
+    void setShard(int index, int count) { shardIndex = index; nShards = count; };
+    void setCacheDir(const string& dir) { cacheDir = dir; };
+    void setIndex(bool use, bool only) { useIndex = use; indexOnly = only; };
+    void setEventRange(uint64_t first, uint64_t last) { firstEvent = first; lastEvent = last; };
+    void setFollow(bool on, double seconds, long events, double idle) {
+      follow = on; followSeconds = seconds; followEvents = events; followIdle = idle;
+    };
+    void setStatsName(const string& name) { statsName = name; };
+    void setScan(bool on) { scanOnly = on; };
+    void setRolling(bool perRun, uint64_t maxBytes) { rollRuns = perRun; rollBytes = maxBytes; };
+    void setSetup(const ChannelMap& map) { setup = map; applySetup(); };
+    int merge(const string& rootName, const vector<string>& manifestNames);
+    int recompute(const string& rootName, const string& friendName);
+    int benchmark(uint64_t nEvents, int multiplicity);
  
   private:
-    void setParameters();
-    void unpack(uint16_t* eventPointer, uint32_t ringSize);
-    void Reset();
-    void Rebin(vector<Int_t> &module);
-    Float_t nanos_per_chan = 0.0625;//ps->ns conv. for mtdc
+    void Init();
+    void applySetup();
+    void makeBranches(TTree* tree, bool rejected);
+    void makeTree();
+    void copySettings(const evt2root& other);
+    int convertFile(const EvtChunk& chunk);
+    int convertSource(RingSource& evtFile, const EvtChunk& chunk);
+    int convertFilePipelined(RingSource& evtFile, const EvtChunk& chunk);
+    int convertRings(RingSource& evtFile, const string& evtName, uint64_t event, uint32_t run);
+    void announceRun(uint32_t run, const string& evtName);
+    int runSerial(const string& rootName, const vector<EvtChunk>& chunks);
+    int runParallel(const string& rootName, const vector<EvtChunk>& chunks);
+    int runProfiles(const string& rootName, const vector<string>& evtNames);
+    int runFormats(const string& rootName, const vector<string>& evtNames);
+    double readBack(const string& rootName);
+    int runCached(const string& rootName, const vector<string>& evtNames);
+    int runFollow(const string& rootName, const vector<string>& evtNames);
+    int runRolled(const string& rootName, const vector<string>& evtNames);
+    int runGroup(const string& base, const vector<EvtChunk>& chunks, vector<string>& files);
+    static bool runOf(const string& evtName, uint32_t& run);
+    static unique_ptr<RingSource> openEvt(const string& evtName);
+    int runScan(const vector<string>& evtNames);
+    bool scanFile(const string& evtName, Telemetry& fileStats);
+    int writeChain(const string& rootName, const vector<string>& files);
+    bool openOutput(const string& rootName);
+    void closeOutput(bool save);
+    void checkpoint(long newEvents);
+    string configKey();
+    string cacheName(const EvtChunk& chunk, const string& config);
+    static vector<EvtChunk> wholeFiles(const vector<string>& evtNames);
+    static bool walkRun(const string& evtName, uint32_t& run, uint64_t& event);
+    static bool carryOn(const vector<string>& names, uint32_t& run, uint64_t& event);
+    int fileStarts(const vector<string>& evtNames, vector<EvtChunk>& chunks);
+    int buildIndexes(const vector<string>& evtNames);
+    static void runBefore(const string& evtName, const EvtIndex& index, uint64_t offset,
+                          uint32_t& run, uint64_t& event);
+    int makeChunks(const vector<string>& evtNames, vector<EvtChunk>& chunks);
+    vector<string> selectFiles(const vector<string>& evtNames);
+    string shardName(const string& rootName);
+    int writeManifest(const string& rootName, const vector<string>& evtNames);
+    static uint64_t chunkBytes(const vector<EvtChunk>& chunks);
+    void writeTelemetry(const string& rootName, double seconds);
+    void writeHistograms(const string& rootName);
+    bool unpack(const RingPayload& payload, SPSEvent& ev);
+    void Rebin(Int_t* module, const Float_t* r);
+    void setParameters(SPSEvent& ev);
+    bool processEvent(const RingPayload& payload, SPSEvent& ev, Telemetry& threadStats);
+    void calibrateBatch(SPSEvent* events, size_t n, ParamBatch& work, bool dither);
+    void flushPending();
+    void fillEvent(const SPSEvent& ev, bool good);
+    void fillTree(const SPSEvent& ev);
+    void fillRejected(const SPSEvent& ev);
+    bool openRaw(RawReader& in, const string& rootName, string& error);
+    void readRaw(RawReader& in, Long64_t entry, SPSEvent& ev);
     string fileName;
+    bool verbose = true;
+    int nJobs = 1;
+    int nThreads = 1;
+    bool vectorScan = false;
+    bool batchCalib = true;
+    OutputLayout layout = LAYOUT_DENSE;
+    OutputFormat format = FORMAT_TTREE;
+    bool treeOutput = true; //false: histograms only, DataTree is never filled
+    bool keepRejected = false; //write events the gates reject to RejectedTree
+    OutputSettings output;
+    bool benchmarkProfiles = false;
+    bool benchmarkFormats = false;
+    //batch selection: output override, [firstFile, lastFile) of the list, then one shard of it
+    string outputName;
+    size_t firstFile = 0;
+    size_t lastFile = SIZE_MAX;
+    int shardIndex = 0;
+    int nShards = 1;
+    vector<string> earlierFiles; //list entries before the selected ones
+    //per evt file root files for incremental conversion; empty for none
+    string cacheDir;
+    //side-car ring indexes: byte-range pieces for the jobs, and physics events [first, last)
+    bool useIndex = false;
+    bool indexOnly = false;
+    uint64_t firstEvent = 0;
+    uint64_t lastEvent = UINT64_MAX;
+    //live conversion of the last evt file in the list
+    bool follow = false;
+    double followSeconds = 10;
+    long followEvents = 100000;
+    double followIdle = 0;
+    bool following = false;
+    long unsaved = 0;
+    chrono::steady_clock::time_point lastSave;
+    bool scanOnly = false; //--scan: decode and count only, no root file
+    //rolled output: a root file per run and/or every rollBytes (0 for no cap)
+    bool rollRuns = false;
+    uint64_t rollBytes = 0;
+    //counters and stage times of everything converted so far, and where the summary goes
+    //(<root file>.json if empty)
+    Telemetry stats;
+    ProgressLine progress;
+    uint64_t inputDone = 0; //input bytes (compressed, for compressed files) converted so far
+    string statsName;
     TFile *rootFile;
     TTree *DataTree;
-    TRandom3 *rand;
+    TTree *RejectedTree;
+    unique_ptr<NTupleOutput> ntuple; //DataTree with --format rntuple, while rootFile is open
+
+    //modules, aliases and the compiled parameter program
+    ChannelMap setup;
+    int nModules;
+    //the setup's histograms, filled by this converter's thread
+    HistogramSet histograms;
 
-    //ROOT branch parameters
-    vector<Int_t> adc1, adc2, adc3, tdc1, mtdc1;
-    Int_t anode1, anode2, scint1, scint2, cathode;    
-    Float_t fp_plane1_tdiff, fp_plane2_tdiff, fp_plane1_tsum, fp_plane2_tsum,
-            fp_plane1_tave, fp_plane2_tave, plastic_sum, anode1_time, anode2_time,
-             plastic_time;
+    //ROOT branch parameters: a 32-entry vector per module slot; scalars are read straight
+    //out of treeEvent
+    vector<vector<Int_t>> moduleBranches;
+    SPSEvent treeEvent;
+    //events unpacked by convertRings() waiting to be calibrated as a batch
+    vector<SPSEvent> pendingEvents;
+    vector<char> pendingGood;
+    size_t nPending;
+    unique_ptr<ParamBatch> calib;
+    //sparse layout hit list
+    static const int MAX_HITS = SPSEvent::N_MODULES*32;
+    Int_t nhits;
+    UChar_t hit_module[MAX_HITS], hit_channel[MAX_HITS];
+    Int_t hit_value[MAX_HITS];
 
-    //geoaddresses
-    int adc1_geo, adc2_geo, adc3_geo, tdc1_geo, mtdc1_id;
-    vector<int> adc_geos;
+    //name of each module slot
+    vector<string> moduleNames;
 
     //module unpackers
     ADCUnpacker adc_unpacker;
@@ -0,0 +1,285 @@
+/*Telemetry.cpp
+ *Conversion counters and stage timers: merging, the JSON summary, the printed summary
+ *and the progress line.
+ *
+ *Oct 2026
+ */
+
+#include "Telemetry.h"
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <cstdio>
+
+using namespace std;
+
+static const char* stageNames[N_STAGES] = {"read", "decode", "calibrate", "fill", "write"};
+static const char* errorNames[TELEMETRY_ERROR_BITS] = {
+  "bad_header", "bad_datum", "bad_id", "no_eoe", "overrun", "overflow"
+};
+
+//tick counter and clock read together at start up; the tick rate is measured against them
+static const uint64_t startTicks = telemetryTicks();
+static const chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+
+/*telemetrySecondsPerTick()
+ *Length of one telemetryTicks() unit, from the ticks and wall time elapsed since start
+ *up. Waits until 50 ms have gone by, so very short runs still get a usable rate.
+ */
+double telemetrySecondsPerTick() {
+  double seconds;
+  uint64_t ticks;
+  do {
+    ticks = telemetryTicks();
+    seconds = chrono::duration<double>(chrono::steady_clock::now()-startTime).count();
+  } while (seconds < 0.05);
+  return ticks > startTicks ? seconds/(ticks-startTicks) : 0;
+}
+
+/*ringTypeName()
+ *NSCLDAQ 11 name of a ring item type, or an empty string for one we don't know
+ */
+static const char* ringTypeName(uint32_t type) {
+  switch (type) {
+    case 1: return "BEGIN_RUN";
+    case 2: return "END_RUN";
+    case 3: return "PAUSE_RUN";
+    case 4: return "RESUME_RUN";
+    case 10: return "PACKET_TYPES";
+    case 11: return "MONITORED_VARIABLES";
+    case 12: return "RING_FORMAT";
+    case 20: return "PERIODIC_SCALERS";
+    case 30: return "PHYSICS_EVENT";
+    case 31: return "PHYSICS_EVENT_COUNT";
+    case 40: return "EVB_FRAGMENT";
+    case 41: return "EVB_UNKNOWN_PAYLOAD";
+    case 42: return "EVB_GLOM_INFO";
+  }
+  return "";
+}
+
+void Telemetry::setModules(const vector<string>& names) {
+  modules = names;
+  moduleErrors.assign(names.size(), array<uint64_t, TELEMETRY_ERROR_BITS+1>());
+  occupancy.assign(names.size(), array<uint64_t, 32>());
+}
+
+void Telemetry::setGates(const vector<string>& names) {
+  gates = names;
+  gateRejects.assign(names.size(), 0);
+}
+
+/*merge()
+ *Adds the counts and stage times of another thread's Telemetry into this one
+ */
+void Telemetry::merge(const Telemetry& other) {
+  for (int s=0; s<N_STAGES; s++) stageTicks[s] += other.stageTicks[s];
+  bytes += other.bytes;
+  for (uint32_t t=0; t<=TELEMETRY_RING_TYPES; t++) rings[t] += other.rings[t];
+  physics += other.physics;
+  filled += other.filled;
+  rejected += other.rejected;
+  malformed += other.malformed;
+  eventsWithErrors += other.eventsWithErrors;
+  strayBlocks += other.strayBlocks;
+  truncatedFiles += other.truncatedFiles;
+  for (size_t slot=0; slot<moduleErrors.size() && slot<other.moduleErrors.size(); slot++) {
+    for (int bit=0; bit<=TELEMETRY_ERROR_BITS; bit++) {
+      moduleErrors[slot][bit] += other.moduleErrors[slot][bit];
+    }
+  }
+  for (size_t k=0; k<gateRejects.size() && k<other.gateRejects.size(); k++) {
+    gateRejects[k] += other.gateRejects[k];
+  }
+  scanned = scanned || other.scanned;
+  for (size_t slot=0; slot<occupancy.size() && slot<other.occupancy.size(); slot++) {
+    for (int chan=0; chan<32; chan++) occupancy[slot][chan] += other.occupancy[slot][chan];
+  }
+  runs.insert(runs.end(), other.runs.begin(), other.runs.end());
+}
+
+/*json()
+ *Machine-readable summary of a conversion. Keys are fixed, so scripts can rely on them;
+ *ring types are keyed by their number ("other" for types of 64 and up). A scan adds
+ *"runs" and "channel_occupancy", 32 counts per module.
+ */
+string Telemetry::json(const string& rootName, double wallSeconds) const {
+  ostringstream out;
+  out<<setprecision(6);
+  double perSecond = wallSeconds > 0 ? 1/wallSeconds : 0;
+  out<<"{\n";
+  out<<"  \"output\": \"";
+  for (char c : rootName) {
+    if (c == '"' || c == '\\') out<<'\\';
+    out<<c;
+  }
+  out<<"\",\n";
+  out<<"  \"wall_seconds\": "<<wallSeconds<<",\n";
+  out<<"  \"input_bytes\": "<<bytes<<",\n";
+  out<<"  \"mb_per_s\": "<<bytes/1.0e6*perSecond<<",\n";
+  out<<"  \"physics_events\": "<<physics<<",\n";
+  out<<"  \"events_per_s\": "<<physics*perSecond<<",\n";
+  out<<"  \"filled_events\": "<<filled<<",\n";
+  out<<"  \"rejected_events\": "<<rejected<<",\n";
+  out<<"  \"malformed_events\": "<<malformed<<",\n";
+  out<<"  \"events_with_errors\": "<<eventsWithErrors<<",\n";
+  out<<"  \"unknown_module_blocks\": "<<strayBlocks<<",\n";
+  out<<"  \"truncated_files\": "<<truncatedFiles<<",\n";
+  out<<"  \"stage_seconds\": {";
+  for (int s=0; s<N_STAGES; s++) {
+    out<<(s ? ", " : "")<<"\""<<stageNames[s]<<"\": "<<seconds((TelemetryStage) s);
+  }
+  out<<"},\n";
+  out<<"  \"ring_types\": {";
+  bool first = true;
+  for (uint32_t t=0; t<=TELEMETRY_RING_TYPES; t++) {
+    if (rings[t] == 0) continue;
+    out<<(first ? "" : ", ")<<"\"";
+    if (t < TELEMETRY_RING_TYPES) out<<t;
+    else out<<"other";
+    out<<"\": "<<rings[t];
+    first = false;
+  }
+  out<<"},\n";
+  out<<"  \"module_errors\": {";
+  for (size_t slot=0; slot<moduleErrors.size(); slot++) {
+    out<<(slot ? "," : "")<<"\n    \""<<modules[slot]<<"\": {\"events\": "
+       <<moduleErrors[slot][TELEMETRY_ERROR_BITS];
+    for (int bit=0; bit<TELEMETRY_ERROR_BITS; bit++) {
+      out<<", \""<<errorNames[bit]<<"\": "<<moduleErrors[slot][bit];
+    }
+    out<<"}";
+  }
+  out<<"\n  },\n";
+  out<<"  \"gate_rejects\": {";
+  for (size_t k=0; k<gateRejects.size(); k++) {
+    out<<(k ? ", " : "")<<"\""<<gates[k]<<"\": "<<gateRejects[k];
+  }
+  out<<"}";
+  if (scanned) {
+    out<<",\n  \"runs\": [";
+    for (size_t k=0; k<runs.size(); k++) out<<(k ? ", " : "")<<runs[k];
+    out<<"],\n";
+    out<<"  \"channel_occupancy\": {";
+    for (size_t slot=0; slot<occupancy.size(); slot++) {
+      out<<(slot ? "," : "")<<"\n    \""<<modules[slot]<<"\": [";
+      for (int chan=0; chan<32; chan++) out<<(chan ? ", " : "")<<occupancy[slot][chan];
+      out<<"]";
+    }
+    out<<"\n  }";
+  }
+  out<<"\n";
+  out<<"}\n";
+  return out.str();
+}
+
+/*print()
+ *Human-readable version of json() for the end of a conversion. After a scan the channel
+ *occupancy is shown as the percentage of good events in which each channel fired.
+ */
+void Telemetry::print(ostream& out, double wallSeconds) const {
+  ios::fmtflags flags = out.flags();
+  streamsize precision = out.precision();
+  out<<fixed<<setprecision(2);
+  out<<"Read "<<bytes/1.0e6<<" MB in "<<wallSeconds<<" s: ";
+  if (wallSeconds > 0) {
+    out<<bytes/1.0e6/wallSeconds<<" MB/s, "<<setprecision(0)<<physics/wallSeconds<<" events/s";
+  }
+  out<<endl<<setprecision(3);
+  out<<"Stage times (s, summed over threads):";
+  for (int s=0; s<N_STAGES; s++) out<<" "<<stageNames[s]<<" "<<seconds((TelemetryStage) s);
+  out<<endl;
+  out<<"Ring items:";
+  for (uint32_t t=0; t<=TELEMETRY_RING_TYPES; t++) {
+    if (rings[t] == 0) continue;
+    const char* name = t < TELEMETRY_RING_TYPES ? ringTypeName(t) : "other";
+    out<<" ";
+    if (*name) out<<name;
+    else out<<"type "<<t;
+    out<<" "<<rings[t];
+  }
+  out<<endl;
+  if (scanned) {
+    out<<"Runs:";
+    for (auto run : runs) out<<" "<<run;
+    out<<endl;
+  }
+  out<<"Physics events: "<<physics;
+  if (!scanned) out<<" filled "<<filled;
+  if (!gates.empty()) out<<" rejected "<<rejected;
+  out<<" malformed "<<malformed<<" with module errors "<<eventsWithErrors<<endl;
+  if (rejected) {
+    out<<"  rejected by gate:";
+    for (size_t k=0; k<gateRejects.size(); k++) out<<" "<<gates[k]<<" "<<gateRejects[k];
+    out<<endl;
+  }
+  for (size_t slot=0; slot<moduleErrors.size(); slot++) {
+    if (moduleErrors[slot][TELEMETRY_ERROR_BITS] == 0) continue;
+    out<<"  "<<modules[slot]<<":";
+    for (int bit=0; bit<TELEMETRY_ERROR_BITS; bit++) {
+      if (moduleErrors[slot][bit]) out<<" "<<errorNames[bit]<<" "<<moduleErrors[slot][bit];
+    }
+    out<<endl;
+  }
+  if (strayBlocks) out<<"  blocks with an unknown geo/id: "<<strayBlocks<<endl;
+  if (truncatedFiles) out<<"  evt files with an incomplete last ring item: "<<truncatedFiles<<endl;
+  if (scanned) {
+    uint64_t good = physics - malformed;
+    out<<"Channel occupancy (% of good events, channels 0-31):"<<endl<<setprecision(1);
+    for (size_t slot=0; slot<occupancy.size(); slot++) {
+      out<<"  "<<modules[slot]<<":";
+      for (int chan=0; chan<32; chan++) {
+        out<<(chan%8 ? " " : "  ")<<(good ? 100.0*occupancy[slot][chan]/good : 0.0);
+      }
+      out<<endl;
+    }
+  }
+  out.flags(flags);
+  out.precision(precision);
+}
+
+/*progressETA()
+ *"  42%  ETA 0:01:23" after bytes of total have taken seconds; empty if total is unknown
+ */
+string progressETA(double seconds, uint64_t bytes, uint64_t total) {
+  if (total == 0 || bytes == 0 || bytes > total) return "";
+  long eta = (long) (seconds*(total-bytes)/bytes + 0.5);
+  char text[64];
+  snprintf(text, sizeof(text), "  %.0f%%  ETA %ld:%02ld:%02ld", 100.0*bytes/total,
+           eta/3600, eta/60%60, eta%60);
+  return text;
+}
+
+void ProgressLine::start(uint64_t totalBytes) {
+  total = totalBytes;
+  begin = last = chrono::steady_clock::now();
+  width = 0;
+}
+
+/*update()
+ *Redraws the progress line at most once a second: physics buffers so far, MB/s, events/s,
+ *and the percentage done and ETA when the total input size is known. Cheap enough to
+ *call every few hundred events.
+ */
+void ProgressLine::update(uint64_t bytes, uint64_t events) {
+  auto now = chrono::steady_clock::now();
+  if (now - last < chrono::seconds(1)) return;
+  last = now;
+  double seconds = chrono::duration<double>(now-begin).count();
+  char rates[128];
+  snprintf(rates, sizeof(rates), "Number of physics buffers: %llu  %.1f MB/s  %.0f events/s",
+           (unsigned long long) events, bytes/1.0e6/seconds, events/seconds);
+  string line = rates + progressETA(seconds, bytes, total);
+  //pad over whatever was left of a longer previous line
+  cout<<"\r"<<line<<string(width > line.size() ? width-line.size() : 0, ' ')<<flush;
+  width = line.size();
+}
+
+/*clear()
+ *Blanks the progress line so the next message starts on a clean line
+ */
+void ProgressLine::clear() {
+  if (width == 0) return;
+  cout<<"\r"<<string(width, ' ')<<"\r"<<flush;
+  width = 0;
+}
@@ -0,0 +1,165 @@
+/*Telemetry.h
+ *Conversion counters and stage timers. Each thread that touches events keeps its own
+ *Telemetry, so counting is plain integer adds with no atomics; the copies are merge()d
+ *once the threads are done. Stages are timed with the time stamp counter where there is
+ *one (a few ns per reading) and converted to seconds only for the summary.
+ *
+ *Stages:
+ *  read      - walking ring items (page faults, decompression, waiting on a stream)
+ *  decode    - unpack(): module blocks into SPSEvent
+ *  calibrate - dithering and derived parameters
+ *  fill      - TTree::Fill(), which includes compressing full baskets, and filling the
+ *              setup's histograms
+ *  write     - final tree write, file close and any merging
+ *Stage times are summed over threads, so with --threads or --jobs they can add up to
+ *more than the wall time.
+ *
+ *With --scan nothing is calibrated or filled; the scan also counts how often each channel
+ *fired and the run numbers of the BEGIN_RUN items.
+ *
+ *ProgressLine is the rate-limited "\r" status line shown while converting.
+ *
+ *Oct 2026
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <string>
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include "UnpackError.h"
+
+enum TelemetryStage {
+  STAGE_READ,
+  STAGE_DECODE,
+  STAGE_CALIBRATE,
+  STAGE_FILL,
+  STAGE_WRITE,
+  N_STAGES
+};
+
+static const int TELEMETRY_ERROR_BITS = 6; //UNPACK_BAD_HEADER ... UNPACK_OVERFLOW
+static const std::uint32_t TELEMETRY_RING_TYPES = 64; //higher ring types are counted together
+
+/*telemetryTicks()
+ *Cheap monotonic time stamp for the stage timers; see telemetrySecondsPerTick()
+ */
+inline std::uint64_t telemetryTicks() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+double telemetrySecondsPerTick();
+
+struct Telemetry {
+  std::uint64_t stageTicks[N_STAGES] = {};
+  std::uint64_t bytes = 0; //ring item bytes read, headers included
+  std::uint64_t rings[TELEMETRY_RING_TYPES+1] = {}; //by ring type; the last entry is all others
+  std::uint64_t physics = 0; //physics items seen
+  std::uint64_t filled = 0; //events written to the tree
+  std::uint64_t rejected = 0; //events rejected by the setup's gates
+  std::uint64_t malformed = 0; //physics items whose word count overruns the item
+  std::uint64_t eventsWithErrors = 0; //events where any module block had an UnpackError
+  std::uint64_t strayBlocks = 0; //module blocks whose geo/id is not in the stack
+  std::uint64_t truncatedFiles = 0; //evt files ending in an incomplete ring item
+  //per module slot: events with each UnpackError bit set, then events with any error
+  std::vector<std::string> modules;
+  std::vector<std::array<std::uint64_t, TELEMETRY_ERROR_BITS+1>> moduleErrors;
+  //per gate: events it rejected (an event can fail more than one)
+  std::vector<std::string> gates;
+  std::vector<std::uint64_t> gateRejects;
+  //--scan only: per module slot and channel, good events in which it fired; BEGIN_RUN runs
+  bool scanned = false;
+  std::vector<std::array<std::uint64_t, 32>> occupancy;
+  std::vector<std::uint32_t> runs;
+
+  void setModules(const std::vector<std::string>& names);
+  void setGates(const std::vector<std::string>& names);
+  void merge(const Telemetry& other);
+  double seconds(TelemetryStage stage) const { return stageTicks[stage]*telemetrySecondsPerTick(); };
+  std::string json(const std::string& rootName, double wallSeconds) const;
+  void print(std::ostream& out, double wallSeconds) const;
+
+  void countRing(std::uint32_t type, std::uint32_t size) {
+    rings[type < TELEMETRY_RING_TYPES ? type : TELEMETRY_RING_TYPES]++;
+    bytes += size;
+  };
+
+  /*countEvent()
+   *Tallies the UnpackError flags of one decoded event, one entry per module slot
+   */
+  void countEvent(const std::uint32_t* errors, std::uint32_t stray) {
+    bool any = stray != 0;
+    strayBlocks += stray;
+    for (std::size_t slot=0; slot<moduleErrors.size(); slot++) {
+      std::uint32_t flags = errors[slot];
+      if (flags == 0) continue;
+      any = true;
+      for (int bit=0; bit<TELEMETRY_ERROR_BITS; bit++) moduleErrors[slot][bit] += (flags >> bit) & 1;
+      moduleErrors[slot][TELEMETRY_ERROR_BITS]++;
+    }
+    eventsWithErrors += any;
+  };
+
+  /*countOccupancy()
+   *Tallies the channels that fired in one decoded event, by module slot
+   */
+  void countOccupancy(const std::uint32_t* fired) {
+    for (std::size_t slot=0; slot<occupancy.size(); slot++) {
+      std::uint32_t bits = fired[slot];
+      while (bits) {
+        occupancy[slot][__builtin_ctz(bits)]++;
+        bits &= bits-1;
+      }
+    }
+  };
+
+  /*countRejected()
+   *Tallies an event rejected by the gates whose bits are set in failed
+   */
+  void countRejected(std::uint32_t failed) {
+    rejected++;
+    for (std::size_t k=0; k<gateRejects.size(); k++) gateRejects[k] += (failed >> k) & 1;
+  };
+};
+
+/*StageTimer
+ *Adds the time between construction and destruction to one stage of a Telemetry
+ */
+class StageTimer {
+  public:
+    StageTimer(Telemetry& t, TelemetryStage s) : stats(t), stage(s), start(telemetryTicks()) {};
+    ~StageTimer() { stats.stageTicks[stage] += telemetryTicks()-start; };
+
+  private:
+    Telemetry& stats;
+    TelemetryStage stage;
+    std::uint64_t start;
+};
+
+std::string progressETA(double seconds, std::uint64_t bytes, std::uint64_t total);
+
+class ProgressLine {
+  public:
+    void start(std::uint64_t totalBytes);
+    void update(std::uint64_t bytes, std::uint64_t events);
+    void clear();
+
+  private:
+    std::uint64_t total = 0; //0 if the input size isn't known, e.g. a stream
+    std::chrono::steady_clock::time_point begin, last;
+    std::size_t width = 0; //length of the line on screen, for clear()
+};
+
+#endif
@@ -0,0 +1,22 @@
+/*UnpackError.h
+ *Error flags reported by the module unpackers. A parsed module event carries the OR of
+ *every problem seen while decoding it, in place of the old thrown error strings, so a
+ *malformed word costs a bit-or instead of a string build and an exception.
+ *
+ *Oct 2026
+ */
+
+#ifndef UNPACKERROR_H
+#define UNPACKERROR_H
+
+enum UnpackError {
+  UNPACK_OK = 0,
+  UNPACK_BAD_HEADER = 1<<0, //expected a header word, found something else
+  UNPACK_BAD_DATUM = 1<<1, //expected a data word, found something else
+  UNPACK_BAD_ID = 1<<2, //geo/id not in the stack; data words skipped
+  UNPACK_NO_EOE = 1<<3, //block not closed by an end-of-event word
+  UNPACK_OVERRUN = 1<<4, //block claims more words than are left in the physics item
+  UNPACK_OVERFLOW = 1<<5 //more data words than channel storage; extras dropped
+};
+
+#endif
@@ -0,0 +1,130 @@
+/*WordScan.cpp
+ *Header classification kernels for forEachBlock(). The AVX2 kernel is compiled with a
+ *target attribute and picked at run time, so the binary still runs on older CPUs.
+ *
+ *Oct 2026
+ */
+
+#include "WordScan.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define WORDSCAN_X86 1
+#endif
+
+using namespace std;
+
+//header type bits as seen in the high 16-bit half of a word
+static const uint16_t ADC_HI_MASK = ADCDescriptor::TYPE_MASK >> 16;
+static const uint16_t ADC_HI_HDR = ADCDescriptor::TYPE_HDR >> 16;
+static const uint16_t MTDC_HI_MASK = mTDCDescriptor::TYPE_MASK >> 16;
+static const uint16_t MTDC_HI_HDR = mTDCDescriptor::TYPE_HDR >> 16;
+static const uint16_t EOE_MARKER = 0xffff;
+
+//scalar classification of words [begin, end) of one 64-word chunk, as chunk-relative bits
+static inline void classifyTail(const uint16_t* words, size_t begin, size_t end, uint64_t& adc,
+                                uint64_t& mtdc) {
+  for (size_t i=begin; i<end; i++) {
+    if ((words[i]&ADC_HI_MASK) == ADC_HI_HDR && words[i-1] != EOE_MARKER) adc |= uint64_t(1) << i;
+    if ((words[i]&MTDC_HI_MASK) == MTDC_HI_HDR) mtdc |= uint64_t(1) << i;
+  }
+}
+
+void classifyWordsScalar(const uint16_t* words, size_t n, uint64_t* adcMask,
+                         uint64_t* mtdcMask) {
+  for (size_t chunk=0; chunk<=n/64; chunk++) {
+    uint64_t adc = 0, mtdc = 0;
+    size_t len = n-chunk*64 < 64 ? n-chunk*64 : 64;
+    classifyTail(words+chunk*64, 0, len, adc, mtdc);
+    adcMask[chunk] = adc;
+    mtdcMask[chunk] = mtdc;
+  }
+}
+
+#ifdef WORDSCAN_X86
+static void classifyWordsSSE2(const uint16_t* words, size_t n, uint64_t* adcMask,
+                              uint64_t* mtdcMask) {
+  const __m128i adcTypeMask = _mm_set1_epi16(ADC_HI_MASK);
+  const __m128i adcHdr = _mm_set1_epi16(ADC_HI_HDR);
+  const __m128i mtdcTypeMask = _mm_set1_epi16(MTDC_HI_MASK);
+  const __m128i mtdcHdr = _mm_set1_epi16(MTDC_HI_HDR);
+  const __m128i marker = _mm_set1_epi16((short)EOE_MARKER);
+  for (size_t chunk=0; chunk<=n/64; chunk++) {
+    const uint16_t* base = words+chunk*64;
+    size_t len = n-chunk*64 < 64 ? n-chunk*64 : 64;
+    uint64_t adcBits = 0, mtdcBits = 0;
+    size_t i = 0;
+    for (; i+8 <= len; i+=8) {
+      __m128i v = _mm_loadu_si128((const __m128i*)(base+i));
+      __m128i prev = _mm_loadu_si128((const __m128i*)(base+i-1));
+      __m128i adc = _mm_andnot_si128(_mm_cmpeq_epi16(prev, marker),
+                                     _mm_cmpeq_epi16(_mm_and_si128(v, adcTypeMask), adcHdr));
+      __m128i mtdc = _mm_cmpeq_epi16(_mm_and_si128(v, mtdcTypeMask), mtdcHdr);
+      //low byte of the mask is the adc lanes, high byte the mtdc lanes
+      uint32_t bits = _mm_movemask_epi8(_mm_packs_epi16(adc, mtdc));
+      adcBits |= uint64_t(bits & 0xff) << i;
+      mtdcBits |= uint64_t(bits >> 8) << i;
+    }
+    classifyTail(base, i, len, adcBits, mtdcBits);
+    adcMask[chunk] = adcBits;
+    mtdcMask[chunk] = mtdcBits;
+  }
+}
+
+__attribute__((target("avx2")))
+static void classifyWordsAVX2(const uint16_t* words, size_t n, uint64_t* adcMask,
+                              uint64_t* mtdcMask) {
+  const __m256i adcTypeMask = _mm256_set1_epi16(ADC_HI_MASK);
+  const __m256i adcHdr = _mm256_set1_epi16(ADC_HI_HDR);
+  const __m256i mtdcTypeMask = _mm256_set1_epi16(MTDC_HI_MASK);
+  const __m256i mtdcHdr = _mm256_set1_epi16(MTDC_HI_HDR);
+  const __m256i marker = _mm256_set1_epi16((short)EOE_MARKER);
+  for (size_t chunk=0; chunk<=n/64; chunk++) {
+    const uint16_t* base = words+chunk*64;
+    size_t len = n-chunk*64 < 64 ? n-chunk*64 : 64;
+    uint64_t adcBits = 0, mtdcBits = 0;
+    size_t i = 0;
+    for (; i+16 <= len; i+=16) {
+      __m256i v = _mm256_loadu_si256((const __m256i*)(base+i));
+      __m256i prev = _mm256_loadu_si256((const __m256i*)(base+i-1));
+      __m256i adc = _mm256_andnot_si256(_mm256_cmpeq_epi16(prev, marker),
+                                        _mm256_cmpeq_epi16(_mm256_and_si256(v, adcTypeMask), adcHdr));
+      __m256i mtdc = _mm256_cmpeq_epi16(_mm256_and_si256(v, mtdcTypeMask), mtdcHdr);
+      //packs works per 128-bit lane: bytes are adc0-7, mtdc0-7, adc8-15, mtdc8-15
+      uint32_t bits = _mm256_movemask_epi8(_mm256_packs_epi16(adc, mtdc));
+      adcBits |= uint64_t((bits & 0xff) | ((bits >> 8) & 0xff00)) << i;
+      mtdcBits |= uint64_t(((bits >> 8) & 0xff) | ((bits >> 16) & 0xff00)) << i;
+    }
+    classifyTail(base, i, len, adcBits, mtdcBits);
+    adcMask[chunk] = adcBits;
+    mtdcMask[chunk] = mtdcBits;
+  }
+}
+#endif
+
+typedef void (*ClassifyFunc)(const uint16_t*, size_t, uint64_t*, uint64_t*);
+
+static ClassifyFunc pickClassifier(const char** name) {
+#ifdef WORDSCAN_X86
+  if (__builtin_cpu_supports("avx2")) {
+    *name = "avx2";
+    return classifyWordsAVX2;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    *name = "sse2";
+    return classifyWordsSSE2;
+  }
+#endif
+  *name = "scalar";
+  return classifyWordsScalar;
+}
+
+static const char* classifierName = "";
+static const ClassifyFunc classifier = pickClassifier(&classifierName);
+
+void classifyWords(const uint16_t* words, size_t n, uint64_t* adcMask, uint64_t* mtdcMask) {
+  classifier(words, n, adcMask, mtdcMask);
+}
+
+const char* classifyWordsImpl() {
+  return classifierName;
+}
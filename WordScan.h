@@ -0,0 +1,88 @@
+/*WordScan.h
+ *Vectorized pre-scan of a physics item. classifyWords() tests every 16-bit word of the
+ *body for an ADC or mTDC header in one pass (AVX2 or SSE2 when available, scalar
+ *otherwise) and returns a bitmask per module type. forEachBlock() then jumps from
+ *candidate to candidate with bit scans instead of testing words one at a time.
+ *classifyWords() fills n/64+1 mask words; bits at or past n are zero.
+ *
+ *Masks mirror the checks of the original scalar loop: bit i of adcMask is set when
+ *words[i] is the high half of an ADC header and words[i-1] is not the 0xffff marker the
+ *readout leaves after an EOE; bit i of mtdcMask when words[i] is the high half of an
+ *mTDC header. words[-1] must be readable.
+ *
+ *Oct 2026
+ */
+
+#ifndef WORDSCAN_H
+#define WORDSCAN_H
+
+#include <cstdint>
+#include <cstddef>
+#include "ADCUnpacker.h"
+#include "mTDCUnpacker.h"
+
+//physics bodies are sized by a 16-bit word count
+static const std::size_t SCAN_MAX_WORDS = 65536;
+static const std::size_t SCAN_MASK_WORDS = SCAN_MAX_WORDS/64 + 1;
+
+void classifyWords(const std::uint16_t* words, std::size_t n, std::uint64_t* adcMask,
+                   std::uint64_t* mtdcMask);
+void classifyWordsScalar(const std::uint16_t* words, std::size_t n, std::uint64_t* adcMask,
+                         std::uint64_t* mtdcMask);
+const char* classifyWordsImpl(); //name of the kernel classifyWords() dispatches to
+
+/*forEachBlock()
+ *Walks the module blocks of a physics body [begin, end), where begin follows the word
+ *count, parsing each with the matching unpacker and handing the result to handle().
+ *Equivalent to testing each word in turn, but skips straight to the next candidate.
+ */
+template<class Handler>
+void forEachBlock(const std::uint16_t* begin, const std::uint16_t* end,
+                  const ADCUnpacker& adc_unpacker, const mTDCUnpacker& mtdc_unpacker,
+                  ParsedModuleEvent& block, Handler handle) {
+  std::uint64_t adcMask[SCAN_MASK_WORDS], mtdcMask[SCAN_MASK_WORDS];
+  std::size_t n = end - begin;
+  classifyWords(begin, n, adcMask, mtdcMask);
+
+  std::size_t pos = 0;
+  while (pos < n) {
+    std::size_t w = pos/64;
+    std::uint64_t bits = (adcMask[w] | mtdcMask[w]) & (~std::uint64_t(0) << (pos%64));
+    while (bits == 0) {
+      if (++w*64 >= n) return;
+      bits = adcMask[w] | mtdcMask[w];
+    }
+    pos = w*64 + __builtin_ctzll(bits);
+    const std::uint16_t* iter;
+    if ((adcMask[w] >> (pos%64)) & 1) iter = adc_unpacker.parse(begin+pos-1, end, block);
+    else iter = mtdc_unpacker.parse(begin+pos-1, end, block);
+    handle(block);
+    if (iter >= end) return;
+    pos = iter - begin;
+  }
+}
+
+/*forEachBlockScalar()
+ *Reference version of forEachBlock(): the original word-by-word loop.
+ */
+template<class Handler>
+void forEachBlockScalar(const std::uint16_t* begin, const std::uint16_t* end,
+                        const ADCUnpacker& adc_unpacker, const mTDCUnpacker& mtdc_unpacker,
+                        ParsedModuleEvent& block, Handler handle) {
+  const std::uint16_t* iterPointer = begin;
+  while (iterPointer<end){
+    //check if header matches; for adc looks like readout puts something like header
+    //after a EOE, skip those too
+    if (ADCUnpacker::isHeader(*iterPointer) && *(iterPointer-1) != 0xffff) {
+      iterPointer = adc_unpacker.parse(iterPointer-1, end, block);
+    } else if (mTDCUnpacker::isHeader(*iterPointer)) {
+      iterPointer = mtdc_unpacker.parse(iterPointer-1, end, block);
+    } else {
+      iterPointer++;
+      continue;
+    }
+    handle(block);
+  }
+}
+
+#endif
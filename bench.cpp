@@ -0,0 +1,553 @@
+/*bench.cpp
+ *Microbenchmark for the module unpackers. Builds a block of synthetic physics events in
+ *memory with EvtGenerator (4 ADCs at geo 3/4/5/8 and an mTDC at id 9, in the reversed
+ *16-bit layout the unpackers expect), times ADCUnpacker::parse() and mTDCUnpacker::parse()
+ *on their own blocks, decodes the events repeatedly the same way evt2root::unpack() does,
+ *and reports the rates along with the number of heap allocations per event.
+ *
+ *Also checks the vectorized header scan (classifyWords/forEachBlock) against the scalar
+ *word-by-word loop, and exits non-zero if they disagree.
+ *
+ *The calibration part times the per-event dithering and parameters (as in evt2root::Rebin()
+ *and setParameters() did before the setup was read at run time) against a hand-written
+ *batched version of the same parameters (kept here as the reference) and the built-in
+ *setup's compiled program (ParamProgram), and checks that all three give the same bits.
+ *
+ *Oct 2026
+ */
+
+#include "ADCUnpacker.h"
+#include "mTDCUnpacker.h"
+#include "WordScan.h"
+#include "Philox.h"
+#include "Calibration.h"
+#include "ChannelMap.h"
+#include "EvtGenerator.h"
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include <new>
+#include <cstring>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BENCH_X86 1
+#endif
+
+using namespace std;
+
+//count every heap allocation made while the benchmark runs
+static size_t nAllocs = 0;
+void* operator new(size_t size) {
+  nAllocs++;
+  void* p = malloc(size);
+  if (!p) throw bad_alloc();
+  return p;
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+/*makeEvents()
+ *Appends nEvents physics bodies (leading word count + module blocks) to words and
+ *records where each begins. gap filler words that match no header (as from modules
+ *that are read out but not unpacked) follow each block.
+ */
+static void makeEvents(int nEvents, int mult, int gap, vector<uint16_t>& words,
+                       vector<size_t>& starts) {
+  EvtGenerator generator(12345);
+  generator.setMultiplicity(mult);
+  generator.setGap(gap);
+  for (int e=0; e<nEvents; e++) {
+    starts.push_back(words.size());
+    generator.physicsBody(words);
+  }
+}
+
+struct BlockSum {
+  long checksum = 0;
+  long errors = 0;
+};
+
+/*decodeAll()
+ *One pass over every event with either the vectorized or the scalar block walk
+ */
+template<bool vectorized>
+static void decodeAll(const vector<uint16_t>& words, const vector<size_t>& starts,
+                      const ADCUnpacker& adc_unpacker, const mTDCUnpacker& mtdc_unpacker,
+                      BlockSum& sum) {
+  ParsedModuleEvent block;
+  auto handle = [&](const ParsedModuleEvent& parsed) {
+    sum.checksum += parsed.s_nData*(parsed.s_slot+2);
+    for (int i=0; i<parsed.s_nData; i++) sum.checksum += parsed.s_data[i].second;
+    sum.errors += parsed.s_errors != UNPACK_OK;
+  };
+  for (size_t start : starts) {
+    const uint16_t* eventPointer = &words[start];
+    const uint16_t* end = eventPointer + *eventPointer + 1;
+    if (vectorized) forEachBlock(eventPointer+1, end, adc_unpacker, mtdc_unpacker, block, handle);
+    else forEachBlockScalar(eventPointer+1, end, adc_unpacker, mtdc_unpacker, block, handle);
+  }
+}
+
+template<bool vectorized>
+static void timeDecode(const char* label, const vector<uint16_t>& words,
+                       const vector<size_t>& starts, const ADCUnpacker& adc_unpacker,
+                       const mTDCUnpacker& mtdc_unpacker, int passes) {
+  BlockSum sum;
+  size_t allocsBefore = nAllocs;
+  auto t0 = chrono::steady_clock::now();
+  for (int pass=0; pass<passes; pass++) {
+    decodeAll<vectorized>(words, starts, adc_unpacker, mtdc_unpacker, sum);
+  }
+  auto t1 = chrono::steady_clock::now();
+  size_t allocs = nAllocs-allocsBefore;
+
+  double seconds = chrono::duration<double>(t1-t0).count();
+  double total = double(starts.size())*passes;
+  double mb = words.size()*2.0*passes/1e6;
+  cout<<label<<endl;
+  cout<<"  events/s:          "<<total/seconds<<endl;
+  cout<<"  MB/s:              "<<mb/seconds<<endl;
+  cout<<"  ns/event:          "<<seconds*1e9/total<<endl;
+  cout<<"  allocations/event: "<<allocs/total<<endl;
+  cout<<"  blocks with errors: "<<sum.errors/passes<<" (checksum "<<sum.checksum/passes<<")"<<endl;
+}
+
+/*timeParse()
+ *Times one unpacker's parse() alone on every block of its type. The blocks are found
+ *beforehand with the scalar walk, so the header search isn't part of the time.
+ */
+template<class Unpacker>
+static void timeParse(const char* label, const Unpacker& unpacker, bool adcBlocks,
+                      const vector<uint16_t>& words, const vector<size_t>& starts,
+                      const ADCUnpacker& adc_unpacker, const mTDCUnpacker& mtdc_unpacker,
+                      int passes) {
+  vector<pair<const uint16_t*, const uint16_t*>> blocks; //block begin, physics item end
+  size_t blockWords = 0;
+  ParsedModuleEvent block;
+  for (size_t start : starts) {
+    const uint16_t* end = &words[start] + words[start] + 1;
+    const uint16_t* iter = &words[start] + 1;
+    while (iter < end) {
+      const uint16_t* next;
+      bool isAdc = ADCUnpacker::isHeader(*iter) && *(iter-1) != 0xffff;
+      if (isAdc) next = adc_unpacker.parse(iter-1, end, block);
+      else if (mTDCUnpacker::isHeader(*iter)) next = mtdc_unpacker.parse(iter-1, end, block);
+      else {
+        iter++;
+        continue;
+      }
+      if (isAdc == adcBlocks) {
+        blocks.push_back(make_pair(iter-1, end));
+        blockWords += next-(iter-1);
+      }
+      iter = next;
+    }
+  }
+
+  long checksum = 0;
+  size_t allocsBefore = nAllocs;
+  auto t0 = chrono::steady_clock::now();
+  for (int pass=0; pass<passes; pass++) {
+    for (auto& b : blocks) {
+      unpacker.parse(b.first, b.second, block);
+      checksum += block.s_nData + block.s_errors;
+      for (int i=0; i<block.s_nData; i++) checksum += block.s_data[i].second;
+    }
+  }
+  double seconds = chrono::duration<double>(chrono::steady_clock::now()-t0).count();
+  size_t allocs = nAllocs-allocsBefore;
+
+  double total = double(starts.size())*passes;
+  cout<<label<<", "<<blocks.size()/double(starts.size())<<" blocks per event"<<endl;
+  cout<<"  events/s:          "<<total/seconds<<endl;
+  cout<<"  blocks/s:          "<<double(blocks.size())*passes/seconds<<endl;
+  cout<<"  MB/s:              "<<blockWords*2.0*passes/1e6/seconds<<endl;
+  cout<<"  allocations/event: "<<allocs/total<<" (checksum "<<checksum/passes<<")"<<endl;
+}
+
+/*checkScan()
+ *classifyWords against classifyWordsScalar on random words rich in header patterns and
+ *0xffff markers, for every length up to a few vectors and at every alignment; then the
+ *full vectorized block walk against the scalar one on the synthetic events.
+ */
+static bool checkScan(const vector<uint16_t>& words, const vector<size_t>& starts,
+                      const ADCUnpacker& adc_unpacker, const mTDCUnpacker& mtdc_unpacker) {
+  mt19937 gen(777);
+  const uint16_t patterns[6] = {0xffff, 0x0200, 0x4000, 0x4009, 0x1a00, 0xc000};
+  vector<uint16_t> random(4096);
+  for (auto& w : random) w = (gen()%3 == 0) ? patterns[gen()%6] : gen();
+
+  uint64_t simdAdc[SCAN_MASK_WORDS], simdMtdc[SCAN_MASK_WORDS];
+  uint64_t refAdc[SCAN_MASK_WORDS], refMtdc[SCAN_MASK_WORDS];
+  for (size_t offset=1; offset<=16; offset++) {
+    for (size_t n=0; n<=300; n++) {
+      classifyWords(&random[offset], n, simdAdc, simdMtdc);
+      classifyWordsScalar(&random[offset], n, refAdc, refMtdc);
+      for (size_t i=0; i<=n/64; i++) {
+        if (simdAdc[i] != refAdc[i] || simdMtdc[i] != refMtdc[i]) {
+          cout<<"scan mismatch at offset "<<offset<<" length "<<n<<endl;
+          return false;
+        }
+      }
+    }
+  }
+
+  BlockSum simd, ref;
+  decodeAll<true>(words, starts, adc_unpacker, mtdc_unpacker, simd);
+  decodeAll<false>(words, starts, adc_unpacker, mtdc_unpacker, ref);
+  if (simd.checksum != ref.checksum || simd.errors != ref.errors) {
+    cout<<"block walk mismatch: "<<simd.checksum<<" vs "<<ref.checksum<<endl;
+    return false;
+  }
+  return true;
+}
+
+//what calibration sees of one event: 5 module slots (adc3 is slot 2, mtdc1 slot 4) and the
+//derived parameters
+struct CalibEvent {
+  uint32_t run;
+  uint64_t event;
+  int32_t module[5][32];
+  int32_t anode1, anode2, scint1, scint2, cathode;
+  float fp_plane1_tdiff, fp_plane1_tsum, fp_plane1_tave, fp_plane2_tdiff, fp_plane2_tsum,
+        fp_plane2_tave, plastic_sum, anode1_time, anode2_time, plastic_time;
+};
+
+static const float NANOS_PER_CHAN = 0.0625;
+
+/*calibrateEvent()
+ *The per-event path: the same loop as evt2root::Rebin() for each module, then the same
+ *arithmetic as evt2root::setParameters()
+ */
+static void calibrateEvent(CalibEvent& ev) {
+  float r[32];
+  for (uint32_t slot=0; slot<5; slot++) {
+    philoxUniform32(ev.run, ev.event, slot, r);
+    int32_t* module = ev.module[slot];
+    for (unsigned int i=0; i<32; i++) {
+      if (module[i] != 0) {
+        float value = module[i]+r[i];
+        module[i] = (int32_t) value;
+      }
+    }
+  }
+  philoxUniform32(ev.run, ev.event, PHILOX_PARAMETER_STREAM, r);
+  const int32_t* mtdc1 = ev.module[4];
+  const int32_t* adc3 = ev.module[2];
+  float mtdc102 = ((float)mtdc1[2]+r[0])*NANOS_PER_CHAN;
+  float mtdc101 = ((float)mtdc1[1]+r[1])*NANOS_PER_CHAN;
+  float mtdc103 = ((float)mtdc1[3]+r[2])*NANOS_PER_CHAN;
+  float mtdc104 = ((float)mtdc1[4]+r[3])*NANOS_PER_CHAN;
+  ev.fp_plane1_tdiff = (mtdc102-mtdc101)/2.0;
+  ev.fp_plane1_tave = (mtdc102+mtdc101)/2.0;
+  ev.fp_plane1_tsum = (mtdc102+mtdc101);
+  ev.fp_plane2_tdiff = (mtdc104-mtdc103)/2.0;
+  ev.fp_plane2_tave = (mtdc104+mtdc103)/2.0;
+  ev.fp_plane2_tsum = (mtdc104+mtdc103);
+  ev.anode1 = adc3[4];
+  ev.anode2 = adc3[5];
+  ev.scint1 = adc3[6];
+  ev.scint2 = adc3[9];
+  ev.cathode = adc3[8];
+  ev.plastic_sum = ((float)ev.scint1+r[4])+((float)ev.scint2+r[5]);
+  ev.anode1_time = (float)mtdc1[5]+r[6];
+  ev.anode2_time = (float)mtdc1[6]+r[7];
+  ev.plastic_time = (float)mtdc1[7]+r[8];
+}
+
+//the built-in setup's parameters hand-written for a batch of events, structure-of-arrays
+//with one array per quantity and one entry per event, the reference for ParamProgram
+const int CALIB_DRAWS = 9; //random numbers used by the parameters of one event
+
+struct CalibBatch {
+  size_t n;
+  //inputs, after dithering: mtdc1 channels 0-7, the two scintillators, and the draws
+  int32_t mtdc[8][CALIB_BATCH];
+  int32_t scint1[CALIB_BATCH], scint2[CALIB_BATCH];
+  float r[CALIB_DRAWS][CALIB_BATCH];
+  //outputs
+  float fp_plane1_tdiff[CALIB_BATCH], fp_plane1_tsum[CALIB_BATCH], fp_plane1_tave[CALIB_BATCH];
+  float fp_plane2_tdiff[CALIB_BATCH], fp_plane2_tsum[CALIB_BATCH], fp_plane2_tave[CALIB_BATCH];
+  float plastic_sum[CALIB_BATCH], anode1_time[CALIB_BATCH], anode2_time[CALIB_BATCH];
+  float plastic_time[CALIB_BATCH];
+};
+
+//parameters of event i; the body of the scalar kernel and the tail of the AVX2 one
+static inline void parametersOne(CalibBatch& b, size_t i, float nanosPerChan) {
+  float mtdc102 = ((float)b.mtdc[2][i]+b.r[0][i])*nanosPerChan;
+  float mtdc101 = ((float)b.mtdc[1][i]+b.r[1][i])*nanosPerChan;
+  float mtdc103 = ((float)b.mtdc[3][i]+b.r[2][i])*nanosPerChan;
+  float mtdc104 = ((float)b.mtdc[4][i]+b.r[3][i])*nanosPerChan;
+  b.fp_plane1_tdiff[i] = (mtdc102-mtdc101)*0.5f;
+  b.fp_plane1_tave[i] = (mtdc102+mtdc101)*0.5f;
+  b.fp_plane1_tsum[i] = mtdc102+mtdc101;
+  b.fp_plane2_tdiff[i] = (mtdc104-mtdc103)*0.5f;
+  b.fp_plane2_tave[i] = (mtdc104+mtdc103)*0.5f;
+  b.fp_plane2_tsum[i] = mtdc104+mtdc103;
+  b.plastic_sum[i] = ((float)b.scint1[i]+b.r[4][i])+((float)b.scint2[i]+b.r[5][i]);
+  b.anode1_time[i] = (float)b.mtdc[5][i]+b.r[6][i];
+  b.anode2_time[i] = (float)b.mtdc[6][i]+b.r[7][i];
+  b.plastic_time[i] = (float)b.mtdc[7][i]+b.r[8][i];
+}
+
+static void computeParametersScalar(CalibBatch& b, float nanosPerChan) {
+  for (size_t i=0; i<b.n; i++) parametersOne(b, i, nanosPerChan);
+}
+
+#ifdef BENCH_X86
+//(float)x + r for 8 events
+__attribute__((target("avx2")))
+static inline __m256 dither8(const int32_t* x, const float* r) {
+  return _mm256_add_ps(_mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i*)x)),
+                       _mm256_loadu_ps(r));
+}
+
+__attribute__((target("avx2")))
+static void computeParametersAVX2(CalibBatch& b, float nanosPerChan) {
+  const __m256 nanos = _mm256_set1_ps(nanosPerChan);
+  const __m256 half = _mm256_set1_ps(0.5f);
+  size_t i = 0;
+  for (; i+8<=b.n; i+=8) {
+    __m256 mtdc102 = _mm256_mul_ps(dither8(b.mtdc[2]+i, b.r[0]+i), nanos);
+    __m256 mtdc101 = _mm256_mul_ps(dither8(b.mtdc[1]+i, b.r[1]+i), nanos);
+    __m256 mtdc103 = _mm256_mul_ps(dither8(b.mtdc[3]+i, b.r[2]+i), nanos);
+    __m256 mtdc104 = _mm256_mul_ps(dither8(b.mtdc[4]+i, b.r[3]+i), nanos);
+    __m256 sum1 = _mm256_add_ps(mtdc102, mtdc101);
+    __m256 sum2 = _mm256_add_ps(mtdc104, mtdc103);
+    _mm256_storeu_ps(b.fp_plane1_tdiff+i, _mm256_mul_ps(_mm256_sub_ps(mtdc102, mtdc101), half));
+    _mm256_storeu_ps(b.fp_plane1_tave+i, _mm256_mul_ps(sum1, half));
+    _mm256_storeu_ps(b.fp_plane1_tsum+i, sum1);
+    _mm256_storeu_ps(b.fp_plane2_tdiff+i, _mm256_mul_ps(_mm256_sub_ps(mtdc104, mtdc103), half));
+    _mm256_storeu_ps(b.fp_plane2_tave+i, _mm256_mul_ps(sum2, half));
+    _mm256_storeu_ps(b.fp_plane2_tsum+i, sum2);
+    _mm256_storeu_ps(b.plastic_sum+i, _mm256_add_ps(dither8(b.scint1+i, b.r[4]+i),
+                                                    dither8(b.scint2+i, b.r[5]+i)));
+    _mm256_storeu_ps(b.anode1_time+i, dither8(b.mtdc[5]+i, b.r[6]+i));
+    _mm256_storeu_ps(b.anode2_time+i, dither8(b.mtdc[6]+i, b.r[7]+i));
+    _mm256_storeu_ps(b.plastic_time+i, dither8(b.mtdc[7]+i, b.r[8]+i));
+  }
+  for (; i<b.n; i++) parametersOne(b, i, nanosPerChan);
+}
+#endif
+
+static void computeParameters(CalibBatch& b, float nanosPerChan) {
+#ifdef BENCH_X86
+  static const bool avx2 = __builtin_cpu_supports("avx2");
+  if (avx2) {
+    computeParametersAVX2(b, nanosPerChan);
+    return;
+  }
+#endif
+  computeParametersScalar(b, nanosPerChan);
+}
+
+/*calibrateBatch()
+ *The batched path with the hand-written parameters, as evt2root::calibrateBatch() was
+ *before the setup was compiled
+ */
+static void calibrateBatch(CalibEvent* events, size_t n, CalibBatch& work) {
+  float r[32];
+  for (size_t first=0; first<n; first+=CALIB_BATCH) {
+    CalibEvent* block = events+first;
+    work.n = n-first < CALIB_BATCH ? n-first : CALIB_BATCH;
+    for (size_t i=0; i<work.n; i++) {
+      CalibEvent& ev = block[i];
+      for (uint32_t slot=0; slot<5; slot++) {
+        philoxUniform32(ev.run, ev.event, slot, r);
+        rebinModule(ev.module[slot], r);
+      }
+      philoxUniform32(ev.run, ev.event, PHILOX_PARAMETER_STREAM, r);
+      for (int k=0; k<CALIB_DRAWS; k++) work.r[k][i] = r[k];
+      for (int c=0; c<8; c++) work.mtdc[c][i] = ev.module[4][c];
+      const int32_t* adc3 = ev.module[2];
+      ev.anode1 = adc3[4];
+      ev.anode2 = adc3[5];
+      ev.scint1 = adc3[6];
+      ev.scint2 = adc3[9];
+      ev.cathode = adc3[8];
+      work.scint1[i] = ev.scint1;
+      work.scint2[i] = ev.scint2;
+    }
+    computeParameters(work, NANOS_PER_CHAN);
+    for (size_t i=0; i<work.n; i++) {
+      CalibEvent& ev = block[i];
+      ev.fp_plane1_tdiff = work.fp_plane1_tdiff[i];
+      ev.fp_plane1_tsum = work.fp_plane1_tsum[i];
+      ev.fp_plane1_tave = work.fp_plane1_tave[i];
+      ev.fp_plane2_tdiff = work.fp_plane2_tdiff[i];
+      ev.fp_plane2_tsum = work.fp_plane2_tsum[i];
+      ev.fp_plane2_tave = work.fp_plane2_tave[i];
+      ev.plastic_sum = work.plastic_sum[i];
+      ev.anode1_time = work.anode1_time[i];
+      ev.anode2_time = work.anode2_time[i];
+      ev.plastic_time = work.plastic_time[i];
+    }
+  }
+}
+
+//CalibEvent fields by setup branch name
+static const struct {
+  const char* name;
+  int32_t CalibEvent::*alias;
+  float CalibEvent::*param;
+} CALIB_FIELDS[] = {
+  {"anode1", &CalibEvent::anode1, nullptr}, {"anode2", &CalibEvent::anode2, nullptr},
+  {"scint1", &CalibEvent::scint1, nullptr}, {"scint2", &CalibEvent::scint2, nullptr},
+  {"cathode", &CalibEvent::cathode, nullptr},
+  {"fp_plane1_tdiff", nullptr, &CalibEvent::fp_plane1_tdiff},
+  {"fp_plane1_tsum", nullptr, &CalibEvent::fp_plane1_tsum},
+  {"fp_plane1_tave", nullptr, &CalibEvent::fp_plane1_tave},
+  {"fp_plane2_tdiff", nullptr, &CalibEvent::fp_plane2_tdiff},
+  {"fp_plane2_tsum", nullptr, &CalibEvent::fp_plane2_tsum},
+  {"fp_plane2_tave", nullptr, &CalibEvent::fp_plane2_tave},
+  {"plastic_sum", nullptr, &CalibEvent::plastic_sum},
+  {"anode1_time", nullptr, &CalibEvent::anode1_time},
+  {"anode2_time", nullptr, &CalibEvent::anode2_time},
+  {"plastic_time", nullptr, &CalibEvent::plastic_time},
+};
+
+//the built-in setup, compiled, with its branches resolved to CalibEvent fields
+struct CompiledSetup {
+  ChannelMap setup;
+  vector<int32_t CalibEvent::*> aliases;
+  vector<float CalibEvent::*> params;
+  CompiledSetup() {
+    for (auto& branch : setup.getBranches()) {
+      for (auto& field : CALIB_FIELDS) {
+        if (branch.name != field.name) continue;
+        if (branch.alias) aliases.push_back(field.alias);
+        else params.push_back(field.param);
+      }
+    }
+  };
+};
+
+/*calibrateCompiled()
+ *The batched path with the setup's compiled program, as in evt2root::calibrateBatch()
+ */
+static void calibrateCompiled(CalibEvent* events, size_t n, const CompiledSetup& compiled,
+                              ParamBatch& work) {
+  const ParamProgram& program = compiled.setup.getProgram();
+  auto& inputs = program.getInputs();
+  auto& aliases = compiled.setup.getAliases();
+  float r[32];
+  for (size_t first=0; first<n; first+=CALIB_BATCH) {
+    CalibEvent* block = events+first;
+    work.n = n-first < CALIB_BATCH ? n-first : CALIB_BATCH;
+    for (size_t i=0; i<work.n; i++) {
+      CalibEvent& ev = block[i];
+      for (uint32_t slot=0; slot<5; slot++) {
+        philoxUniform32(ev.run, ev.event, slot, r);
+        rebinModule(ev.module[slot], r);
+      }
+      philoxUniform32(ev.run, ev.event, PHILOX_PARAMETER_STREAM, r);
+      for (int k=0; k<program.getDraws(); k++) work.column(program.drawColumn(k))[i] = r[k];
+      for (size_t k=0; k<inputs.size(); k++) {
+        work.column(program.inputColumn(k))[i] = ev.module[inputs[k].slot][inputs[k].channel];
+      }
+      for (size_t k=0; k<aliases.size(); k++) {
+        ev.*compiled.aliases[k] = ev.module[aliases[k].slot][aliases[k].channel];
+      }
+    }
+    program.evaluate(work);
+    for (size_t k=0; k<program.getOutputs(); k++) {
+      const float* column = work.column(program.outputColumn(k));
+      for (size_t i=0; i<work.n; i++) block[i].*compiled.params[k] = column[i];
+    }
+  }
+}
+
+/*timeCalibration()
+ *The three calibration paths over the same unpacked events. Each pass starts from a fresh
+ *copy of the raw channels (the copy is timed in all). Returns false if they differ.
+ */
+static bool timeCalibration(int nEvents, int mult, int passes) {
+  mt19937 gen(4242);
+  uniform_int_distribution<int> chan(0, 31), value(0, 4095);
+  vector<CalibEvent> raw(nEvents);
+  for (int e=0; e<nEvents; e++) {
+    CalibEvent& ev = raw[e];
+    memset(&ev, 0, sizeof(ev));
+    ev.run = 425;
+    ev.event = e;
+    for (auto& module : ev.module) {
+      for (int i=0; i<32; i++) module[i] = -1000;
+      for (int i=0; i<mult; i++) module[chan(gen)] = value(gen);
+    }
+  }
+
+  vector<CalibEvent> perEvent(nEvents), batched(nEvents), compiled(nEvents);
+  vector<CalibBatch> work(1);
+  CompiledSetup setup;
+  ParamBatch columns;
+  setup.setup.getProgram().prepare(columns);
+  double seconds[3];
+  for (int method=0; method<3; method++) {
+    vector<CalibEvent>& events = method == 0 ? perEvent : method == 1 ? batched : compiled;
+    auto t0 = chrono::steady_clock::now();
+    for (int pass=0; pass<passes; pass++) {
+      memcpy(events.data(), raw.data(), nEvents*sizeof(CalibEvent));
+      if (method == 0) {
+        for (auto& ev : events) calibrateEvent(ev);
+      } else if (method == 1) {
+        calibrateBatch(events.data(), nEvents, work[0]);
+      } else {
+        calibrateCompiled(events.data(), nEvents, setup, columns);
+      }
+    }
+    seconds[method] = chrono::duration<double>(chrono::steady_clock::now()-t0).count();
+  }
+
+  bool same = memcmp(perEvent.data(), batched.data(), nEvents*sizeof(CalibEvent)) == 0;
+  bool sameCompiled = memcmp(perEvent.data(), compiled.data(), nEvents*sizeof(CalibEvent)) == 0;
+  double total = double(nEvents)*passes;
+  cout<<"Calibration (philox "<<philoxImpl()<<", kernels "<<calibrationImpl()<<"), "<<mult
+      <<" hits per module"<<endl;
+  cout<<" per-event"<<endl;
+  cout<<"  events/s:          "<<total/seconds[0]<<endl;
+  cout<<"  ns/event:          "<<seconds[0]*1e9/total<<endl;
+  cout<<" batched"<<endl;
+  cout<<"  events/s:          "<<total/seconds[1]<<endl;
+  cout<<"  ns/event:          "<<seconds[1]*1e9/total<<endl;
+  cout<<" compiled setup ("<<setup.setup.getProgram().getOps()<<" ops, "<<paramProgramImpl()
+      <<")"<<endl;
+  cout<<"  events/s:          "<<total/seconds[2]<<endl;
+  cout<<"  ns/event:          "<<seconds[2]*1e9/total<<endl;
+  cout<<"Batched vs per-event results: "<<(same ? "OK" : "FAILED")<<endl;
+  cout<<"Compiled setup vs per-event results: "<<(sameCompiled ? "OK" : "FAILED")<<endl;
+  return same && sameCompiled;
+}
+
+int main(int argc, char* argv[]) {
+  int nEvents = 100000, mult = 8, gap = 0, passes = 20;
+  if (argc > 1) mult = atoi(argv[1]);
+  if (argc > 2) gap = atoi(argv[2]);
+  if (mult > 32) mult = 32;
+
+  vector<uint16_t> words;
+  vector<size_t> starts;
+  words.reserve(nEvents*(5*(mult+2)*2+4*gap+1));
+  makeEvents(nEvents, mult, gap, words, starts);
+
+  ADCUnpacker adc_unpacker;
+  mTDCUnpacker mtdc_unpacker;
+  const int geos[4] = {3, 4, 5, 8};
+  for (int i=0; i<4; i++) adc_unpacker.addModule(geos[i], i);
+  mtdc_unpacker.addModule(9, 4);
+
+  bool scanOK = checkScan(words, starts, adc_unpacker, mtdc_unpacker);
+  cout<<"Header scan ("<<classifyWordsImpl()<<") vs scalar: "<<(scanOK ? "OK" : "FAILED")<<endl;
+
+  cout<<"Unpacker decode, "<<mult<<" hits per module, "<<gap<<" filler words per block"<<endl;
+  timeParse(" ADCUnpacker::parse", adc_unpacker, true, words, starts, adc_unpacker,
+            mtdc_unpacker, passes);
+  timeParse(" mTDCUnpacker::parse", mtdc_unpacker, false, words, starts, adc_unpacker,
+            mtdc_unpacker, passes);
+  timeDecode<false>(" scalar scan", words, starts, adc_unpacker, mtdc_unpacker, passes);
+  timeDecode<true>(" vectorized scan", words, starts, adc_unpacker, mtdc_unpacker, passes);
+
+  bool calibOK = timeCalibration(nEvents, mult, passes/4);
+  return scanOK && calibOK ? 0 : 1;
+}
@@ -12,6 +12,10 @@
  *Updated to have better error handling, and have a more general application
  *Gordon M. April 2019
  *
+ *Now only the module descriptor for the generic ModuleUnpacker, which reads whole 32-bit
+ *words.
+ *Oct 2026
+ *
  *NOTE: This version is specifically designed to unpack data that come in reverse!!
  */
 
@@ -19,30 +23,37 @@
 #ifndef MTDCUNPACKER_H 
 #define MTDCUNPACKER_H 
 
-#include <vector>
-#include <utility>
-#include <cstdint>
-struct ParsedmTDCEvent {
-  int s_id;
-  int s_res;
-  int s_count;
-  int s_eventNumber;   
-  std::vector<std::pair<int, std::uint16_t>> s_data;
-};
+#include "ModuleUnpacker.h"
+
+//This is the main place where changes need to be made from one module to another; all else mostly name changes
+//useful masks and shifts for mTDC:
+struct mTDCDescriptor {
+  //in spectcl is just 0xc0000000, here use f to remove readout errors
+  static const std::uint32_t TYPE_MASK = 0xf0000000;
+  static const std::uint32_t TYPE_HDR = 0x40000000;
+  static const std::uint32_t TYPE_DATA = 0x00000000;
+  static const std::uint32_t TYPE_TRAIL = 0xc0000000;
+
+  static const unsigned ID_SHIFT = 16;
+  static const std::uint32_t ID_MASK = 0x00ff0000;
 
-class mTDCUnpacker {
-  public:
-    std::pair< uint16_t*, ParsedmTDCEvent> parse( uint16_t* begin,  uint16_t* end, int id);
-    bool isHeader(std::uint16_t word);
-
-  private:
-    bool isData(std::uint16_t word);
-    bool isEOE(std::uint16_t word); 
-   
-    void unpackHeader(std::uint16_t* word, ParsedmTDCEvent& event);
-    void unpackDatum(std::uint16_t* word, ParsedmTDCEvent& event); 
-    uint16_t* unpackData( uint16_t* begin,  uint16_t* end, ParsedmTDCEvent& event); 
+  //header-specific:
+  static const unsigned COUNT_SHIFT = 0;
+  static const std::uint32_t COUNT_MASK = 0x000003ff;
+  static const int COUNT_EXTRA = 1; //count includes the eob
+  static const unsigned CRATE_SHIFT = 0;
+  static const std::uint32_t CRATE_MASK = 0;
+  static const unsigned RES_SHIFT = 12;
+  static const std::uint32_t RES_MASK = 0x0000f000;
+
+  //data-specific:
+  static const unsigned CHAN_SHIFT = 16;
+  static const std::uint32_t CHAN_MASK = 0x001f0000;
+  static const std::uint32_t DATA_MASK = 0x0000ffff;
+
+  static const bool BAD_DATUM_DROPS_BLOCK = true; //a bad datum loses the whole block, as before
 };
 
+typedef ModuleUnpacker<mTDCDescriptor> mTDCUnpacker;
+
 #endif
-        
@@ -2,12 +2,245 @@
 #include <TROOT.h>
 #include <TApplication.h>
 #include <string>
+#include <cstring>
+#include <cstdlib>
+#include <vector>
 #include <iostream>
+#include <memory>
+#include <cstdio>
+#include <cstdint>
 using namespace std;
 
+//options that are followed by a value
+static const char* const VALUE_OPTIONS[] = {
+  "--jobs", "-j", "--threads", "-t", "--layout", "--format", "--profile", "--compression",
+  "--compression-level", "--basket-size", "--autoflush", "--autosave", "--benchmark",
+  "--multiplicity", "--list", "--output", "--shard", "--files", "--stats", "--cache",
+  "--events", "--roll-size", "--save-seconds", "--save-events", "--idle", "--setup",
+  "--recompute"
+};
+
+static bool takesValue(const char* arg) {
+  for (const char* option : VALUE_OPTIONS) {
+    if (!strcmp(arg, option)) return true;
+  }
+  return false;
+}
+
 int main(int argc, char* argv[]) {
-  TApplication app("app", &argc, argv);//if someone wants root graphics
-  evt2root converter;
+  //pull out our own options; single-dash ones we don't know (-b, -q ...) are left for ROOT
+  int jobs = 1, threads = 1;
+  bool simdScan = false, batchCalib = true, treeOutput = true, keepRejected = false;
+  OutputLayout layout = LAYOUT_DENSE;
+  OutputFormat format = FORMAT_TTREE;
+  OutputSettings output;
+  bool benchmarkProfiles = false, benchmarkFormats = false;
+  //individual output options override the profile whatever order they are given in
+  string algorithm;
+  int level = -1, basketSize = -1;
+  long long autoFlush = 0, autoSave = 0;
+  bool autoFlushGiven = false, autoSaveGiven = false; //0 is a setting of its own: off
+  //batch mode: no prompt for the list, and optionally only part of it
+  string listName, outputName, cacheDir, statsName, recomputeName;
+  size_t firstFile = 0, lastFile = SIZE_MAX;
+  int shardIndex = 0, nShards = 1;
+  vector<string> mergeManifests;
+  bool follow = false, rollRuns = false, scan = false;
+  double rollMB = 0;
+  double followSeconds = 10, followIdle = 0;
+  long followEvents = 100000;
+  bool useIndex = false, indexOnly = false;
+  uint64_t firstEvent = 0, lastEvent = UINT64_MAX;
+  uint64_t benchmarkEvents = 0;
+  int multiplicity = 4;
+  //detector setup; the built-in SPS one unless --setup is given
+  ChannelMap setup;
+  vector<char*> rootArgs;
+  rootArgs.push_back(argv[0]);
+  for (int i=1; i<argc; i++) {
+    if (takesValue(argv[i]) && i+1 >= argc) {
+      cout<<"Missing value for "<<argv[i]<<endl;
+      return 1;
+    }
+    if (!strcmp(argv[i], "--jobs") || !strcmp(argv[i], "-j")) {
+      jobs = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--threads") || !strcmp(argv[i], "-t")) {
+      threads = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--simd-scan")) {
+      simdScan = true;
+    } else if (!strcmp(argv[i], "--per-event-calib")) {
+      batchCalib = false;
+    } else if (!strcmp(argv[i], "--rejected-tree")) {
+      keepRejected = true;
+    } else if (!strcmp(argv[i], "--no-tree")) {
+      treeOutput = false;
+    } else if (!strcmp(argv[i], "--layout")) {
+      string name = argv[++i];
+      if (name == "sparse") layout = LAYOUT_SPARSE;
+      else if (name == "dense") layout = LAYOUT_DENSE;
+      else {
+        cout<<"Unknown output layout: "<<name<<" (dense or sparse)"<<endl;
+        return 1;
+      }
+    } else if (!strcmp(argv[i], "--format")) {
+      string name = argv[++i];
+      if (name == "rntuple") format = FORMAT_RNTUPLE;
+      else if (name == "ttree") format = FORMAT_TTREE;
+      else {
+        cout<<"Unknown output format: "<<name<<" (ttree or rntuple)"<<endl;
+        return 1;
+      }
+    } else if (!strcmp(argv[i], "--profile")) {
+      if (!output.setProfile(argv[++i])) {
+        cout<<"Unknown output profile: "<<argv[i]<<" (quicklook, default or archival)"<<endl;
+        return 1;
+      }
+    } else if (!strcmp(argv[i], "--compression")) {
+      algorithm = argv[++i];
+    } else if (!strcmp(argv[i], "--compression-level")) {
+      level = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--basket-size")) {
+      basketSize = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--autoflush")) {
+      autoFlush = atoll(argv[++i]);
+      autoFlushGiven = true;
+    } else if (!strcmp(argv[i], "--autosave")) {
+      autoSave = strtod(argv[++i], nullptr);
+      autoSaveGiven = true;
+    } else if (!strcmp(argv[i], "--benchmark-profiles")) {
+      benchmarkProfiles = true;
+    } else if (!strcmp(argv[i], "--benchmark-formats")) {
+      benchmarkFormats = true;
+    } else if (!strcmp(argv[i], "--benchmark")) {
+      benchmarkEvents = strtod(argv[++i], nullptr);
+    } else if (!strcmp(argv[i], "--multiplicity")) {
+      multiplicity = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--list")) {
+      listName = argv[++i];
+    } else if (!strcmp(argv[i], "--output")) {
+      outputName = argv[++i];
+    } else if (!strcmp(argv[i], "--shard")) {
+      if (sscanf(argv[++i], "%d/%d", &shardIndex, &nShards) != 2 || nShards < 1 ||
+          shardIndex < 0 || shardIndex >= nShards) {
+        cout<<"Bad shard: "<<argv[i]<<" (i/N with 0 <= i < N)"<<endl;
+        return 1;
+      }
+    } else if (!strcmp(argv[i], "--files")) {
+      //a:b is the half open range of list entries [a, b); either end may be left out
+      string range = argv[++i];
+      size_t colon = range.find(':');
+      if (colon == string::npos) {
+        cout<<"Bad file range: "<<range<<" (a:b)"<<endl;
+        return 1;
+      }
+      if (colon > 0) firstFile = strtoul(range.substr(0, colon).c_str(), nullptr, 10);
+      if (colon+1 < range.size()) lastFile = strtoul(range.substr(colon+1).c_str(), nullptr, 10);
+    } else if (!strcmp(argv[i], "--stats")) {
+      statsName = argv[++i];
+    } else if (!strcmp(argv[i], "--cache")) {
+      cacheDir = argv[++i];
+    } else if (!strcmp(argv[i], "--index")) {
+      useIndex = true;
+    } else if (!strcmp(argv[i], "--build-index")) {
+      indexOnly = true;
+    } else if (!strcmp(argv[i], "--events")) {
+      //a:b is the half open range of physics events [a, b); 1e6 style numbers are fine
+      string range = argv[++i];
+      size_t colon = range.find(':');
+      if (colon == string::npos) {
+        cout<<"Bad event range: "<<range<<" (a:b)"<<endl;
+        return 1;
+      }
+      if (colon > 0) firstEvent = strtod(range.substr(0, colon).c_str(), nullptr);
+      if (colon+1 < range.size()) lastEvent = strtod(range.substr(colon+1).c_str(), nullptr);
+    } else if (!strcmp(argv[i], "--scan")) {
+      scan = true;
+    } else if (!strcmp(argv[i], "--roll-runs")) {
+      rollRuns = true;
+    } else if (!strcmp(argv[i], "--roll-size")) {
+      rollMB = atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--follow")) {
+      follow = true;
+    } else if (!strcmp(argv[i], "--save-seconds")) {
+      followSeconds = atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--save-events")) {
+      followEvents = atol(argv[++i]);
+    } else if (!strcmp(argv[i], "--idle")) {
+      followIdle = atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--setup")) {
+      if (!setup.load(argv[++i])) {
+        cout<<setup.getError()<<endl;
+        return 1;
+      }
+    } else if (!strcmp(argv[i], "--print-setup")) {
+      cout<<ChannelMap::defaultSetup();
+      return 0;
+    } else if (!strcmp(argv[i], "--recompute")) {
+      recomputeName = argv[++i];
+    } else if (!strcmp(argv[i], "--merge")) {
+      //--merge output.root shard0.manifest shard1.manifest ...
+      while (i+1<argc && argv[i+1][0] != '-') mergeManifests.push_back(argv[++i]);
+    } else if (!strncmp(argv[i], "--", 2)) {
+      cout<<"Unknown option: "<<argv[i]<<endl;
+      return 1;
+    } else rootArgs.push_back(argv[i]);
+  }
+  if (!algorithm.empty() && !output.setAlgorithm(algorithm)) {
+    cout<<"Unknown compression: "<<algorithm<<" (zlib, lzma, lz4 or zstd)"<<endl;
+    return 1;
+  }
+  if (level >= 0) output.level = level > 9 ? 9 : level;
+  if (basketSize > 0) output.basketSize = basketSize;
+  if (autoFlushGiven) output.autoFlush = autoFlush;
+  if (autoSaveGiven) output.autoSave = autoSave;
+  int rootArgc = rootArgs.size();
+  TApplication app("app", &rootArgc, rootArgs.data());//if someone wants root graphics
+  if (!mergeManifests.empty()) {
+    if (mergeManifests.size() < 2) {
+      cout<<"--merge needs an output root file and at least one manifest"<<endl;
+      return 1;
+    }
+    string mergedName = mergeManifests[0];
+    mergeManifests.erase(mergeManifests.begin());
+    evt2root merger("", false);
+    merger.setOutput(output);
+    return merger.merge(mergedName, mergeManifests) ? 0 : 1;
+  }
+  if (!recomputeName.empty()) {
+    evt2root recomputer("", false);
+    recomputer.setSetup(setup);
+    recomputer.setThreads(threads);
+    recomputer.setBatchCalibration(batchCalib);
+    recomputer.setOutput(output);
+    return recomputer.recompute(recomputeName, outputName) ? 0 : 1;
+  }
+  //without --list the list name is asked for, as before; the benchmark needs no list
+  unique_ptr<evt2root> created(listName.empty() && benchmarkEvents == 0 ? new evt2root() :
+                               new evt2root(listName));
+  evt2root& converter = *created;
+  converter.setSetup(setup);
+  converter.setJobs(jobs);
+  converter.setThreads(threads);
+  converter.setVectorScan(simdScan);
+  converter.setBatchCalibration(batchCalib);
+  converter.setLayout(layout);
+  converter.setFormat(format);
+  converter.setTreeOutput(treeOutput);
+  converter.setKeepRejected(keepRejected);
+  converter.setOutput(output);
+  converter.setBenchmarkProfiles(benchmarkProfiles);
+  converter.setBenchmarkFormats(benchmarkFormats);
+  converter.setOutputName(outputName);
+  converter.setFileRange(firstFile, lastFile);
+  converter.setShard(shardIndex, nShards);
+  converter.setCacheDir(cacheDir);
+  converter.setIndex(useIndex, indexOnly);
+  converter.setEventRange(firstEvent, lastEvent);
+  converter.setFollow(follow, followSeconds, followEvents, followIdle);
+  converter.setStatsName(statsName);
+  converter.setScan(scan);
+  converter.setRolling(rollRuns, rollMB > 0 ? rollMB*1.0e6 : 0);
   cout<<"---------------SPS evt2root---------------"<<endl;
-  converter.run();
+  if (benchmarkEvents > 0) return converter.benchmark(benchmarkEvents, multiplicity) ? 0 : 1;
+  return converter.run() ? 0 : 1;
 }